@@ -7,54 +7,115 @@
 #include "third_party/stb/stb_easy_font.h"
 
 #include <GeomBasics.h>
+#include "mesh/MeshSnapshot.h"
+#include "mesh/MeshLoader.h"
+#include "mesh/Trace.h"
+#include "gl/DisplayData.h"
+#include "gl/ProgramCache.h"
 
 #include <wx/wx.h>
+#include <wx/stdpaths.h>
 
 #include <stdexcept>
 #include <filesystem>
+#include <chrono>
+#include <cmath>
+#include <iterator>
+#include <utility>
 
+// every program reads the camera and colors from the Frame block (FrameUniforms.h)
 static const char* kVS = R"(#version 460 core
+)" FRAME_UNIFORMS_GLSL R"(
 layout(location=0) in vec3 aPos;
-uniform mat4 uView;
-uniform mat4 uProj;
 void main(){ gl_Position = uProj * uView * vec4(aPos,1.0); }
 )";
 
 static const char* kFS = R"(#version 460 core
+)" FRAME_UNIFORMS_GLSL R"(
 out vec4 FragColor;
-uniform vec4 uColor;
-void main(){ FragColor = uColor; }
+uniform uint uMaterial;
+void main(){ FragColor = uColors[uMaterial]; }
 )";
 
-static const char* kPickVS = R"(#version 460 core
-layout(location=0) in vec3 aPos;
-uniform mat4 uView, uProj;
-void main(){ gl_Position = uProj * uView * vec4(aPos,1); }
+// mesh fill/edges/pick: chunk draws carry their chunk index in baseInstance,
+// with the level slot above kSlotShift (nonzero: not the exact primitives);
+// compact (unorm16) positions are lattice steps from the chunk's cell, placed
+// relative to the eye cell in integers (FrameUniforms.h)
+static const char* kMeshVS = R"(#version 460 core
+)" FRAME_UNIFORMS_GLSL R"(
+layout(location=0) in vec3 aPos;     // world xyz, or xy = steps / 65535 from the chunk cell
+struct ChunkInfo { ivec2 cell; uint firstTri; uint firstEdge; uint firstLevel; uint pad; };
+layout(std430, binding=1) readonly buffer Chunks { ChunkInfo chunks[]; };
+layout(std430, binding=5) readonly buffer LevelEdges { uint levelFirstEdge[]; };
+flat out uint vFirstTri;             // ~0u for LOD draws
+flat out uint vFirstEdge;            // first GPU edge of the drawn range
+void main(){
+  ChunkInfo c = chunks[gl_BaseInstance & 0x00FFFFFFu];
+  uint slot = uint(gl_BaseInstance) >> 24u;
+  vFirstTri = slot != 0u ? 0xFFFFFFFFu : c.firstTri;
+  vFirstEdge = slot != 0u ? levelFirstEdge[c.firstLevel + slot - 1u] : c.firstEdge;
+  if (uEyeCell.z != 0) {
+    ivec2 steps = c.cell + ivec2(round(aPos.xy * 65535.0)) - uEyeCell.xy;
+    gl_Position = uLatticeProj * vec4(vec2(steps), 0.0, 1.0);
+  } else
+    gl_Position = uProj * uView * vec4(aPos, 1.0);
+}
+)";
+
+// fill: the element's ElementAttrib (ElementAttribs.h) picks its color;
+// edges are dropped unless their EdgeClass bits meet uEdgeMask; the hover
+// highlight just uses its material
+static const char* kMeshFS = R"(#version 460 core
+)" FRAME_UNIFORMS_GLSL R"(
+flat in uint vFirstTri;
+flat in uint vFirstEdge;
+uniform uint uMaterial;
+uniform uint uFlagMask;      // ElementFlag bits to show
+uniform uint uEdgeMask;      // EdgeClass bits to show
+uniform float uPoorQuality;
+struct ElementAttrib { uint flagsPalette; float scalar; };
+layout(std430, binding=3) readonly buffer ElementOfTri { uint elementOfTri[]; };
+layout(std430, binding=4) readonly buffer Elements { ElementAttrib elements[]; };
+layout(std430, binding=6) readonly buffer EdgeFlags { uint edgeFlags[]; };   // 4 per uint
+out vec4 FragColor;
+void main(){
+  if ( uMaterial == 2u ) {
+    uint e = vFirstEdge + uint(gl_PrimitiveID);
+    if ( ((edgeFlags[e >> 2u] >> ((e & 3u) * 8u)) & uEdgeMask) == 0u )
+      discard;
+  }
+  vec4 color = uColors[uMaterial];
+  if ( uMaterial == 0u && vFirstTri != 0xFFFFFFFFu ) {
+    ElementAttrib a = elements[elementOfTri[vFirstTri + uint(gl_PrimitiveID)]];
+    uint flags = a.flagsPalette & uFlagMask;
+    color = uColors[(a.flagsPalette >> 16) & 0xFFu];
+    if ( (flags & 2u) != 0u )       // Poor: the worse, the closer to its color
+      color = mix( uColors[8], color, clamp( a.scalar / uPoorQuality, 0.0, 1.0 ) );
+    if ( (flags & 1u) != 0u )       // Picked
+      color = uColors[7];
+  }
+  FragColor = color;
+}
 )";
+static_assert( int( Material::Picked ) == 7 && int( Material::Poor ) == 8, "kMeshFS palette slots" );
+static_assert( uint16_t( ElementFlag::Picked ) == 1 && uint16_t( ElementFlag::Poor ) == 2, "kMeshFS flag bits" );
+static_assert( int( Material::Edge ) == 2, "kMeshFS edge material" );
 
 static const char* kPickFS = R"(#version 460 core
-uniform uint uId;           // 0..16M
-layout(location=0) out vec4 outC;
+uniform uint uKind;         // PickKind, goes in the top 4 bits
+flat in uint vFirstTri;
+layout(location=0) out uint outId;
 void main(){
-  // pack uId into RGB
-  uint r = (uId >> 16u) & 255u;
-  uint g = (uId >> 8u)  & 255u;
-  uint b = (uId)        & 255u;
-  outC = vec4(r,g,b,255)/255.0;
+  // gl_PrimitiveID restarts with every chunk draw; offset it to the GPU triangle index (0 = no hit)
+  outId = (uKind << 28u) | ((vFirstTri + uint(gl_PrimitiveID) + 1u) & 0x0FFFFFFFu);
 }
 )";
 
-// text.vs
+// text.vs; shares kFS
 static const char* kTextVS = R"(#version 460 core
+)" FRAME_UNIFORMS_GLSL R"(
 layout( location = 0 ) in vec2 aPos;
-uniform mat4 uProj;
-void main() { gl_Position = uProj * vec4( aPos, 0.0, 1.0 ); })";
-
-// text.fs
-static const char* kTextFS = R"(#version 460 core
-uniform vec4 uColor;
-out vec4 FragColor;
-void main() { FragColor = uColor; })";
+void main() { gl_Position = uPixelProj * vec4( aPos, 0.0, 1.0 ); })";
 
 
 static wxGLAttributes MakeCanvasAttrs()
@@ -79,10 +140,18 @@ EVT_MIDDLE_DOWN( GLCanvas::onMouse )
 EVT_MIDDLE_UP( GLCanvas::onMouse )
 EVT_LEFT_UP( GLCanvas::onMouse )
 EVT_MOUSEWHEEL( GLCanvas::onMouse )
+EVT_LEAVE_WINDOW( GLCanvas::onMouse )
+EVT_TIMER( wxID_ANY, GLCanvas::onFrameTimer )
 wxEND_EVENT_TABLE()
 
+GLCanvas::~GLCanvas()
+{
+	// a layout change being prepared; its CallAfter dies with the canvas
+	if ( prepareThread_.joinable() ) prepareThread_.join();
+}
+
 GLCanvas::GLCanvas( wxWindow* parent )
-	: wxGLCanvas( parent, MakeCanvasAttrs(), wxID_ANY )
+	: wxGLCanvas( parent, MakeCanvasAttrs(), wxID_ANY ), frameTimer_( this )
 {
 	wxGLContextAttrs want;
 	want.CoreProfile()
@@ -114,9 +183,23 @@ void GLCanvas::OnInitGL()
 	glEnable( GL_DEPTH_TEST );
 	glClearColor( 0.1f, 0.1f, 0.12f, 1.f );
 
+	// linked programs persist per user; the second launch only loads binaries
+	ProgramCache::setDirectory( std::filesystem::path( wxStandardPaths::Get().GetUserLocalDataDir().ToStdWstring() ) / "shaders" );
+	const auto shaders0 = ProgramCache::stats();
+
 	createPipeline();
-	pickShader_.build( kPickVS, kPickFS );
-	textShader_.build( kTextVS, kTextFS );
+	meshShader_.build( kMeshVS, kMeshFS );
+	meshShader_.setFloat( "uPoorQuality", kPoorQuality );
+	pickShader_.build( kMeshVS, kPickFS );
+	textShader_.build( kTextVS, kFS );
+	labels_.create();
+	layers_.create();
+
+	const auto& shaders = ProgramCache::stats();
+	// verbose log only: a wxLogMessage box would pop up on every launch
+	wxLogVerbose( "Shaders: %zu of %zu programs from the binary cache (%.1f ms cache I/O)",
+				  shaders.hits - shaders0.hits, shaders.hits + shaders.misses - shaders0.hits - shaders0.misses,
+				  shaders.ms - shaders0.ms );
 
 	initialized_ = true;
 }
@@ -124,10 +207,24 @@ void GLCanvas::OnInitGL()
 void 
 GLCanvas::OnPaint( wxPaintEvent& )
 {
+	Trace::Scope trace( "OnPaint" );
 	wxPaintDC dc( this );
 	SetCurrent( *ctx_ );
 	if ( !initialized_ ) OnInitGL();
 
+	const auto frameStart = std::chrono::steady_clock::now();
+	frameRequested_ = false;
+	lastFrame_ = frameStart;
+	const bool preview = std::chrono::duration<double, std::milli>( frameStart - lastCameraChange_ ).count() < kRefineDelayMs;
+
+	profiler_.beginFrame();
+	auto frameScope = profiler_.begin( "frame" );
+	resolvePicks();
+	{
+		FrameProfiler::Scope scope( profiler_, "upload" );
+		stepUpload();
+	}
+
 	int w, h; GetClientSize( &w, &h );
 	glViewport( 0, 0, w, h );
 	glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
@@ -147,44 +244,303 @@ GLCanvas::OnPaint( wxPaintEvent& )
 	const float bottom = camCenterY_ - halfH;
 	const float top = camCenterY_ + halfH;
 
-	// Z range can be tight around your mesh plane
-	Mat4 proj = ortho( left, right, bottom, top, -1.f, 1.f );
-	// View is just identity (or a translate if you want Z offset)
-	Mat4 view = translate( 0.f, 0.f, 0.f );
-
-	renderScene( view, proj );
-
-	// For each node, project and draw number
-	for ( const auto& n : GeomBasics::nodeList )
+	// Static layers: the cached image stands in while it covers the view
+	// (rescaled while navigating); otherwise they are rendered into it around
+	// the view, previews without labels and overlay. Before the view leaves
+	// it, a fresh image is rendered ahead one band per frame (LayerCache)
+	const LayerCache::Window window{ left, right, bottom, top };
+	const bool reuse = preview ? layers_.covers( window, w, h, camZoom_ ) : layers_.exact( window, w, h, camZoom_ );
+	if ( !reuse )
+	{
+		FrameProfiler::Scope scope( profiler_, "layers" );
+		const LayerCache::Window area = layers_.begin( window, w, h, camZoom_, !preview );
+		const int lw = layers_.width(), lh = layers_.height();
+		updateFrameUniforms( area, lw, lh );
+		{
+			FrameProfiler::Scope scope( profiler_, "cull" );
+			cullChunks( area.left, area.right, area.bottom, area.top, wantPick_ );
+		}
+		renderScene( preview );
+		if ( !preview )
+		{
+			FrameProfiler::Scope scope( profiler_, "labels" );
+			drawLabels( area.left, area.right, area.bottom, area.top, lw, lh );
+		}
+		layers_.end();
+		glViewport( 0, 0, w, h );
+	}
+	else
 	{
-		float sx, sy;
-		if ( projectToScreen( { (float)n->x, (float)n->y, 0.f }, view, proj, w, h, sx, sy ) )
+		if ( layers_.refreshDue( window, w, h, camZoom_ ) )
+		{
+			FrameProfiler::Scope scope( profiler_, "layers" );
+			const LayerCache::Band b = layers_.beginBand( window, camZoom_, !preview );
+			const int lw = layers_.width(), lh = layers_.bandHeight();
+			// every band renders at the zoom the refresh started with, so LOD
+			// and labels match across bands
+			const float zoom = std::exchange( camZoom_, b.zoom );
+			updateFrameUniforms( b.area, lw, layers_.height() );
+			{
+				FrameProfiler::Scope scope( profiler_, "cull" );
+				cullChunks( b.band.left, b.band.right, b.band.bottom, b.band.top, false );
+			}
+			renderScene( !b.complete );
+			if ( b.complete )
+			{
+				FrameProfiler::Scope scope( profiler_, "labels" );
+				drawLabels( b.band.left, b.band.right, b.band.bottom, b.band.top, lw, lh );
+			}
+			camZoom_ = zoom;
+			layers_.endBand();
+			glViewport( 0, 0, w, h );
+			// see the refresh through even if the camera stops
+			if ( layers_.refreshing() )
+				requestFrame( Redraw::Dynamic );
+		}
+		if ( wantPick_ )
 		{
-			auto label = std::to_string( n->GetNumber() );
-			drawText2D( sx + 3.f, sy - 3.f, label.c_str() ); // small offset so it doesn’t sit exactly on the point
+			FrameProfiler::Scope scope( profiler_, "cull" );
+			cullChunks( left, right, bottom, top, true );
 		}
 	}
 
+	updateFrameUniforms( window, w, h );
+	{
+		FrameProfiler::Scope scope( profiler_, "composite" );
+		layers_.composite( window );
+	}
+	drawHover();
+
 	if ( wantPick_ )
 	{
+		FrameProfiler::Scope scope( profiler_, "pick" );
 		// map window coords to FBO coords (same size here)
 		int px = pickPos_.x, py = h - 1 - pickPos_.y; // flip Y
-		renderPick( view, proj, w, h );
-		uint32_t id = picker_.read( px, py );
-		pickedTri_ = (id == 0) ? -1 : int( id - 1 );
+		renderPick( w, h );
+		// lands in a buffer; resolvePicks() collects it on a later frame
+		picker_.requestRead( px, py, displayGeneration_ );
+		glViewport( 0, 0, w, h );
 		wantPick_ = false;
+	}
+
+	if ( profiler_.enabled() )
+	{
+		FrameProfiler::Scope scope( profiler_, "hud" );
+		drawText2D( 8.f, 8.f, profiler_.hudText().c_str() );
+	}
+
+	profiler_.end( frameScope );
+	profiler_.endFrame();
+	indirect_.end();
+	{
+		Trace::Scope traceSwap( "SwapBuffers" );
+		SwapBuffers();
+	}
+	// keep frames coming until the pick readback has landed
+	if ( picker_.pending() )
+		requestFrame( Redraw::Dynamic );
+	// the full frame follows once the camera has been still for a moment
+	previewShown_ = preview;
+	if ( preview && !frameTimer_.IsRunning() )
+		frameTimer_.StartOnce( int( kRefineDelayMs ) );
+	// the first frame showing a new mesh closes the open/QMorph latency
+	if ( firstFramePending_ )
+	{
+		firstFramePending_ = false;
+		Trace::instant( "First frame" );
+	}
+}
+
+void
+GLCanvas::updateFrameUniforms( const LayerCache::Window& window, int w, int h )
+{
+	// every program reads camera and colors from the Frame block
+	FrameUniforms u{};
+	// Z range can be tight around the mesh plane; the view is identity
+	u.view = translate( 0.f, 0.f, 0.f );
+	u.proj = ortho( window.left, window.right, window.bottom, window.top, -1.f, 1.f );
+	u.pixelProj = orthoPixels( float( w ), float( h ) );
+	if ( chunks_.localized )
+	{
+		// eye-relative in double: the eye snaps to the lattice point nearest the
+		// window center, and the projection takes over the remainder
+		const double step = chunks_.latticeStep;
+		const double cx = 0.5 * (double( window.left ) + window.right);
+		const double cy = 0.5 * (double( window.bottom ) + window.top);
+		const int32_t eyeX = int32_t( std::llround( (cx - chunks_.latticeX) / step ) );
+		const int32_t eyeY = int32_t( std::llround( (cy - chunks_.latticeY) / step ) );
+		const double ex = chunks_.latticeX + eyeX * step, ey = chunks_.latticeY + eyeY * step;
+		u.latticeProj = ortho( float( (window.left - ex) / step ), float( (window.right - ex) / step ),
+							   float( (window.bottom - ey) / step ), float( (window.top - ey) / step ), -1.f, 1.f );
+		u.eyeCell[0] = eyeX;
+		u.eyeCell[1] = eyeY;
+		u.eyeCell[2] = 1;
+	}
+	u.viewport[0] = float( w );
+	u.viewport[1] = float( h );
+	u.viewport[2] = camZoom_;
+	const Color palette[] = { triColor_, hoverColor_, edgeColor_,
+		labelColors_[0], labelColors_[1], labelColors_[2], { 1.0f, 1.0f, 1.0f, 1.0f },
+		pickedColor_, poorColor_ };
+	static_assert( std::size( palette ) == size_t( Material::Count ), "one color per material" );
+	for ( size_t i = 0; i < std::size( palette ); ++i )
+	{
+		u.colors[i][0] = palette[i].r; u.colors[i][1] = palette[i].g;
+		u.colors[i][2] = palette[i].b; u.colors[i][3] = palette[i].a;
+	}
+	frame_.update( u );
+}
+
+void
+GLCanvas::requestFrame( Redraw why )
+{
+	const auto now = std::chrono::steady_clock::now();
+	if ( why == Redraw::Camera )
+		lastCameraChange_ = now;
+	else if ( why == Redraw::Scene )
+		layers_.invalidate();
+	if ( frameRequested_ )
+		return;         // folded into the frame already on its way
+	frameRequested_ = true;
+
+	const double since = std::chrono::duration<double, std::milli>( now - lastFrame_ ).count();
+	if ( since >= kFrameIntervalMs )
+		Refresh( false );
+	else
+		frameTimer_.StartOnce( std::max( 1, int( std::ceil( kFrameIntervalMs - since ) ) ) );
+}
+
+void
+GLCanvas::onFrameTimer( wxTimerEvent& )
+{
+	if ( frameRequested_ )
+	{
+		Refresh( false );
+		return;
+	}
+	if ( !previewShown_ )
+		return;
+	// refine once the camera has been still for kRefineDelayMs
+	const double still = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - lastCameraChange_ ).count();
+	if ( still >= kRefineDelayMs )
+		requestFrame( Redraw::Dynamic );
+	else
+		frameTimer_.StartOnce( std::max( 1, int( std::ceil( kRefineDelayMs - still ) ) ) );
+}
 
-		if ( pickedTri_ >= 0 )
+void
+GLCanvas::resolvePicks()
+{
+	PickResult hit;
+	uint64_t generation = 0;
+	while ( picker_.poll( hit, generation ) )
+	{
+		// ids index the chunk order of the mesh the pass drew
+		if ( generation != displayGeneration_ ) continue;
+
+		// the pick pass draws chunk-ordered triangles, two per quad; report the element
+		const int elem = (hit.kind == PickKind::Triangle && snapshot_ && hit.id < chunks_.primOfGpu.size())
+			? int( snapshot_->elementOfPrimitive( chunks_.primOfGpu[hit.id] ) ) : -1;
+		setElementFlag( pickedElem_, ElementFlag::Picked, false );
+		setElementFlag( elem, ElementFlag::Picked, true );
+		pickedElem_ = elem;
+		const double ms = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - pickClicked_ ).count();
+
+		if ( pickedElem_ >= 0 )
 		{
-			wxLogMessage( "Picked triangle: %d", pickedTri_ );
+			wxLogMessage( "Picked element: %d (%.2f ms after the click)", pickedElem_, ms );
 		}
 		else
 		{
-			wxLogMessage( "No hit" );
+			wxLogMessage( "No hit (%.2f ms after the click)", ms );
 		}
+		if ( onPick_ ) onPick_( pickedElem_ );
 	}
+}
+
+void
+GLCanvas::setElementFlag( int elem, ElementFlag flag, bool on )
+{
+	if ( elem < 0 || size_t( elem ) >= elements_.size() ) return;
+	ElementAttrib& a = elements_[elem];
+	const uint16_t flags = on ? uint16_t( a.flags | uint16_t( flag ) ) : uint16_t( a.flags & ~uint16_t( flag ) );
+	if ( flags == a.flags ) return;
+	a.flags = flags;
+	elementBuf_.patch( size_t( elem ) * sizeof( ElementAttrib ), &a, sizeof( ElementAttrib ) );
+	requestFrame();     // the fill is in the cached layers
+}
+
+void
+GLCanvas::SetShowPoorElements( bool b )
+{
+	showPoorElements_ = b;
+	requestFrame();
+}
+
+void
+GLCanvas::SetShowEdgeClass( EdgeClass c, bool b )
+{
+	edgeMask_ = b ? edgeMask_ | uint32_t( c ) : edgeMask_ & ~uint32_t( c );
+	requestFrame();     // the edges are in the cached layers
+}
+
+void
+GLCanvas::SetProfilerHud( bool b )
+{
+	profiler_.setEnabled( b );
+	requestFrame( Redraw::Dynamic );
+}
+
+bool
+GLCanvas::ExportFrameTimings( const std::string& path ) const
+{
+	return profiler_.exportCsv( path );
+}
 
-	SwapBuffers();
+// Chunks whose box meets the ortho window become this frame's draw commands,
+// each at the coarsest level of detail that stays within kLodErrorPx: fill
+// commands, then edge commands, then (for picking) exact fill commands, all
+// in one ring region
+void
+GLCanvas::cullChunks( float left, float right, float bottom, float top, bool exact )
+{
+	fillDraws_ = edgeDraws_ = exactDraws_ = 0;
+	visibleTris_ = 0;
+	const auto& chunks = chunks_.chunks;
+	if ( chunks.empty() || !mesh_.valid() ) return;
+
+	IndirectRing::Command* cmd = indirect_.begin( chunks.size() * 3 );
+	std::vector<uint32_t>& visible = visibleChunks_;
+	visible.clear();
+	for ( uint32_t i = 0; i < chunks.size(); ++i )
+	{
+		const auto& c = chunks[i];
+		if ( c.maxX >= left && c.minX <= right && c.maxY >= bottom && c.minY <= top )
+			visible.push_back( i );
+	}
+	for ( uint32_t i : visible )
+	{
+		const uint32_t slot = chunks_.selectSlot( chunks[i], camZoom_, kLodErrorPx );
+		const auto& r = chunks_.range( chunks[i], slot );
+		if ( !r.triCount ) continue;
+		cmd[fillDraws_++] = { r.triCount * 3, 1, r.firstTri * 3, GLint( chunks[i].firstVertex ), i | (slot << kSlotShift) };
+		visibleTris_ += r.triCount;
+	}
+	for ( uint32_t i : visible )
+	{
+		const uint32_t slot = chunks_.selectSlot( chunks[i], camZoom_, kLodErrorPx );
+		const auto& r = chunks_.range( chunks[i], slot );
+		if ( r.edgeCount )
+			cmd[fillDraws_ + edgeDraws_++] = { r.edgeCount * 2, 1, r.firstEdge * 2, GLint( chunks[i].firstVertex ), i | (slot << kSlotShift) };
+	}
+	// picks must resolve to real triangles
+	if ( exact )
+		for ( uint32_t i : visible )
+		{
+			const auto& c = chunks[i];
+			if ( c.triCount )
+				cmd[fillDraws_ + edgeDraws_ + exactDraws_++] = { c.triCount * 3, 1, c.firstTri * 3, GLint( c.firstVertex ), i };
+		}
 }
 
 
@@ -199,101 +555,227 @@ void GLCanvas::OnResize( wxSizeEvent& e )
 	e.Skip();
 }
 
-void 
-GLCanvas::RegenerateMeshDisplay()
+void
+GLCanvas::ShowSnapshot( std::shared_ptr<const MeshSnapshot> snap, bool fit )
 {
-	uint32_t maxId = 0;
-	for ( const auto& n : GeomBasics::nodeList ) maxId = std::max<uint32_t>( maxId, n->GetNumber() );
-	std::vector<float> vertices( maxId * 3 );
-	for ( const auto& n : GeomBasics::nodeList )
-	{
-		const uint32_t id = n->GetNumber() - 1;
-		vertices[id * 3 + 0] = float( n->x );
-		vertices[id * 3 + 1] = float( n->y );
-		vertices[id * 3 + 2] = 0.0f;
-	}
+	if ( !snap ) return;
+	Trace::Scope trace( "ShowSnapshot" );
+	SetCurrent( *ctx_ );
+	if ( !initialized_ ) OnInitGL();
 
-	auto add_triangle = [&]( const Edge& e1, const Edge& e2,
-							 std::vector<uint32_t>& indices,
-							 uint32_t start )
-		{
-			indices[start] = uint32_t( e1.leftNode->GetNumber() - 1 );
-			indices[start+1] = uint32_t( e1.rightNode->GetNumber() - 1 );
-			if ( !e2.leftNode->equals( e1.leftNode ) && !e2.leftNode->equals( e1.rightNode ) )
-				indices[start+2] = uint32_t( e2.leftNode->GetNumber() - 1 );
-			else
-				indices[start+2] = uint32_t( e2.rightNode->GetNumber() - 1 );
+	// prepared and diffed in this frame: tiny snapshots only
+	cancelUpload();
+	auto d = DisplayData::prepare( std::move( snap ), displayOptions_ );
+	mesh_.setFormat( d->format() );
+	mesh_.upload( d->vertexData(), d->vertexBytes(), d->chunks.indices );
+	pslg_.create( mesh_.Vbo(), d->format() );
+	pslg_.uploadSegments( d->chunks.edges.data(), d->chunks.edges.size() / 2 );
+	labels_.upload( d->labels, d->labelGrids );
+	adoptDisplay( *d, fit );
+}
 
-		};
+void
+GLCanvas::ShowDisplay( std::shared_ptr<DisplayData> d, bool fit )
+{
+	if ( !d || !d->snapshot ) return;
+	cancelUpload();
+	incoming_ = std::move( d );
+	incomingFit_ = fit;
+	requestFrame( Redraw::Dynamic );
+}
 
-	std::vector<uint32_t> indices( GeomBasics::triangleList.size() * 3 + 6 * GeomBasics::elementList.size(), 0 );
-	for ( size_t i = 0; const auto& t : GeomBasics::triangleList )
-	{
-		const auto e1 = t->edgeList[0];
-		const auto e2 = t->edgeList[1];
-		add_triangle( *e1, *e2, indices, uint32_t( i * 3 ) );
-		++i;
-	}
+void
+GLCanvas::SetQuantizedVertices( bool b )
+{
+	auto o = displayOptions_;
+	o.quantized = b;
+	setDisplayOptions( o );
+}
 
-	for ( size_t i = 0; const auto& e : GeomBasics::elementList )
-	{
-		const auto e1 = e->edgeList[0];
-		const auto e2 = e->edgeList[1];
-		add_triangle( *e1, *e2, indices, uint32_t( i * 3 ) );
-		++i;
-	
-		if ( e->edgeList.size() == 4 )
-		{
-			const auto e3 = e->edgeList[2];
-			const auto e4 = e->edgeList[3];
-			add_triangle( *e3, *e4, indices, uint32_t( i * 3 ) );
-			++i;
-		}
-	}
+void
+GLCanvas::SetOptimizedOrder( bool b )
+{
+	auto o = displayOptions_;
+	o.reorder = b;
+	setDisplayOptions( o );
+}
 
-	mesh_.upload( vertices, indices );
+void
+GLCanvas::setDisplayOptions( const DisplayOptions& o )
+{
+	if ( o == displayOptions_ ) return;
+	displayOptions_ = o;
+	// same snapshot, other layout; staged like a new mesh. A display already
+	// on its way is re-prepared when it is adopted (adoptDisplay)
+	if ( !incoming_ )
+		prepareDisplay();
+}
 
-	// After mesh_.upload(vertices, indices);
-	pslg_.create( mesh_.Vbo() );  // add a tiny getter in your Mesh to expose the position VBO id
+void
+GLCanvas::prepareDisplay()
+{
+	// the running one reports back and starts over if anything changed
+	if ( !snapshot_ || preparing_ ) return;
+	if ( prepareThread_.joinable() ) prepareThread_.join();     // done already
+	preparing_ = true;
+	prepareThread_ = std::thread( [this, snap = snapshot_, o = displayOptions_]
+		{
+			Trace::setThreadName( "DisplayPrepare" );
+			auto d = DisplayData::prepare( snap, o );
+			CallAfter( [this, d] { preparedDisplay( d ); } );
+		} );
+}
 
-	// Build segments from your QMorph data (example: boundary/constrained edges)
-	std::vector<Segment> segs;
-	segs.reserve( GeomBasics::edgeList.size() );
-	for ( const auto& e : GeomBasics::edgeList )
+void
+GLCanvas::preparedDisplay( std::shared_ptr<DisplayData> d )
+{
+	preparing_ = false;
+	// another mesh was shown or is on its way meanwhile; it gets re-prepared
+	// in its own turn if its layout is stale
+	if ( d->snapshot != snapshot_ || incoming_ )
+		return;
+	if ( !(d->options == displayOptions_) )
 	{
-		// choose your criterion: boundary edges, constrained edges, etc.
-		// Example (pseudo): if (e->isConstrained) ...
-		// Fallback: push all edges to visualize connectivity:
-		segs.push_back( { uint32_t( e->leftNode->GetNumber() - 1 ),
-						 uint32_t( e->rightNode->GetNumber() - 1 ) } );
+		prepareDisplay();       // toggled again while this one was built
+		return;
 	}
-	pslg_.uploadSegments( segs );
+	ShowDisplay( std::move( d ), false );
+}
 
-	float minx = FLT_MAX, miny = FLT_MAX, maxx = -FLT_MAX, maxy = -FLT_MAX;
-	for ( const auto& n : GeomBasics::nodeList )
-	{
-		minx = std::min( minx, float( n->x ) );
-		miny = std::min( miny, float( n->y ) );
-		maxx = std::max( maxx, float( n->x ) );
-		maxy = std::max( maxy, float( n->y ) );
-	}
-	fitToMesh( minx, miny, maxx, maxy );
+void
+GLCanvas::ShowLoadedMesh( const std::string& path, std::shared_ptr<DisplayData> d, bool geometryLoaded )
+{
+	// failed or cancelled before GeomBasics was touched: the old mesh stands
+	if ( !d && !geometryLoaded ) return;
+	pendingGeometry_ = geometryLoaded ? std::string() : path;
+	if ( d )
+		ShowDisplay( std::move( d ), true );
+	else    // failed after the lists were emptied; show them as they are
+		ShowSnapshot( std::make_shared<const MeshSnapshot>(), false );
+}
 
-	Refresh( false );
+void
+GLCanvas::cancelUpload()
+{
+	if ( !incoming_ ) return;
+	incoming_.reset();
+	mesh_.cancelStage();
+	pslg_.cancelStage();
+	labels_.cancelStage();
 }
 
+// Streams the pending display into the staging buffers for at most
+// kUploadBudgetMs per frame; the old mesh stays on screen until it is all
+// there, then everything is swapped in at once
 void
-GLCanvas::LoadMesh( const std::string& path )
+GLCanvas::stepUpload()
 {
-	std::filesystem::path inputPath( path );
+	if ( !incoming_ ) return;
+	Trace::Scope trace( "stepUpload" );
+	using clock = std::chrono::steady_clock;
+	const auto t0 = clock::now();
+	const DisplayData& d = *incoming_;
+	bool done = false;
+	do
+	{
+		size_t budget = kUploadSliceBytes;
+		done = mesh_.stage( d.vertexData(), d.vertexBytes(), d.chunks.indices, budget )
+			&& pslg_.stageSegments( d.chunks.edges.data(), d.chunks.edges.size() / 2, budget )
+			&& labels_.stage( d.labels, budget );
+	} while ( !done && std::chrono::duration<double, std::milli>( clock::now() - t0 ).count() < kUploadBudgetMs );
 
-	GeomBasics::clearLists();
+	if ( !done )
+	{
+		requestFrame( Redraw::Dynamic );    // keep frames coming until the upload is through
+		return;
+	}
+	mesh_.setFormat( d.format() );
+	mesh_.commit();
+	pslg_.create( mesh_.Vbo(), d.format() );
+	pslg_.commitSegments();
+	labels_.commit( d.labelGrids );
+	auto ready = std::move( incoming_ );
+	adoptDisplay( *ready, incomingFit_ );
+}
 
-	GeomBasics::setParams( inputPath.filename().string(), inputPath.parent_path().string(), false, false );
-	GeomBasics::loadMesh();
-	GeomBasics::findExtremeNodes();
+void
+GLCanvas::adoptDisplay( DisplayData& d, bool fit )
+{
+	Trace::Scope trace( "adoptDisplay" );
+	// prepared by a job that started before the layout was last toggled
+	const bool stale = !(d.options == displayOptions_);
+	firstFramePending_ = true;
+	++displayGeneration_;
+	snapshot_ = d.snapshot;
+	index_ = std::move( d.index );
+	chunks_ = std::move( d.chunks );
+	chunks_.indices = {};   // on the GPU now; the maps and boxes are what we keep
+	chunks_.edges = {};
+	chunks_.quantized = {};
+
+	// chunk table for kMeshVS, indexed by baseInstance
+	struct ChunkInfo { int32_t cellX, cellY; uint32_t firstTri, firstEdge, firstLevel, pad = 0; };
+	std::vector<ChunkInfo> info( chunks_.chunks.size() );
+	for ( size_t i = 0; i < info.size(); ++i )
+	{
+		const auto& c = chunks_.chunks[i];
+		info[i] = chunks_.localized
+			? ChunkInfo{ c.cellX, c.cellY, c.firstTri, c.firstEdge, c.firstLevel }
+			: ChunkInfo{ 0, 0, c.firstTri, c.firstEdge, c.firstLevel };
+	}
+	chunkBuf_.update( info.data(), info.size() * sizeof( ChunkInfo ) );
+	std::vector<uint32_t> levelEdges( chunks_.levels.size() );
+	for ( size_t l = 0; l < levelEdges.size(); ++l ) levelEdges[l] = chunks_.levels[l].firstEdge;
+	levelEdgeBuf_.update( levelEdges.data(), levelEdges.size() * sizeof( uint32_t ) );
+
+	// edge categories, classified once per mesh; the View toggles only change uEdgeMask
+	chunks_.edgeFlags.resize( (chunks_.edgeFlags.size() + 3) & ~size_t( 3 ), 0 );
+	edgeFlagBuf_.update( chunks_.edgeFlags.data(), chunks_.edgeFlags.size() );
+	chunks_.edgeFlags = {};
+
+	// per-element state for kMeshFS; highlights patch single records later
+	elements_ = std::move( d.elements );
+	elementBuf_.update( elements_.data(), elements_.size() * sizeof( ElementAttrib ) );
+	elementOfTriBuf_.update( d.elementOfTri.data(), d.elementOfTri.size() * sizeof( uint32_t ) );
+	d.elementOfTri = {};
+
+	hoverElem_ = hoverNode_ = hoverEdge_ = -1;
+	pickedElem_ = -1;
+
+	const MeshSnapshot& s = *snapshot_;
+	const auto& st = s.stats;
+	const double uploaded = double( mesh_.LastUploadBytes() + pslg_.lastUploadBytes() + labels_.lastUploadBytes() );
+	const wxString source = st.fromCache
+		? wxString::Format( "cache %.1f ms", st.cacheMs )
+		: wxString::Format( "extract %.1f ms on %u threads [gather %.1f, nodes %.1f, elements %.1f, edges %.1f, bbox %.1f]",
+							st.extractMs, st.threads, st.gatherMs, st.nodesMs, st.elementsMs, st.edgesMs, st.bboxMs );
+	const wxString load = st.constructMs > 0
+		? wxString::Format( "I/O %.1f, parse %.1f, dedupe %.1f, construct %.1f ms | ",
+							st.ioMs, st.parseMs, st.dedupeMs, st.constructMs )
+		: wxString();
+	const wxString order = chunks_.reordered()
+		? wxString::Format( " | ACMR %.2f -> %.2f (%.1f ms)", chunks_.order.acmrBefore, chunks_.order.acmrAfter, chunks_.order.ms )
+		: wxString();
+	wxLogStatus( "%zu nodes, %zu tris, %zu quads, %zu edges (%.1f MB) | %s | index %.1f ms | uploaded %.2f MB, vertices %.2f MB%s%s",
+				 s.nodeCount(), s.triCount(), s.quadCount(), s.edgeCount(), s.bytes() / (1024.0 * 1024.0),
+				 load + source, index_.buildMs(), uploaded / (1024.0 * 1024.0),
+				 mesh_.VertexBytes() / (1024.0 * 1024.0), chunks_.localized ? " (16-bit)" : "", order );
+
+	if ( fit )
+		fitToMesh( s.minX, s.minY, s.maxX, s.maxY );
+	if ( stale )
+		prepareDisplay();
+
+	requestFrame();
+}
 
-	RegenerateMeshDisplay();
+std::function<void()>
+GLCanvas::TakeGeometryLoader()
+{
+	if ( pendingGeometry_.empty() ) return {};
+	std::filesystem::path p( pendingGeometry_ );
+	pendingGeometry_.clear();
+	return [p] { MeshLoader::loadGeometry( p ); };
 }
 
 void GLCanvas::destroyPipeline()
@@ -347,8 +829,9 @@ GLCanvas::onMouse( wxMouseEvent& e )
 	{
 		// request a pick; store window coords (origin top-left)
 		pickPos_ = e.GetPosition();
+		pickClicked_ = std::chrono::steady_clock::now();
 		wantPick_ = true;
-		Refresh( false );
+		requestFrame( Redraw::Dynamic );
 	}	
 	else if ( e.LeftDown() ) 
 		lastDrag_ = e.GetPosition();
@@ -361,7 +844,7 @@ GLCanvas::onMouse( wxMouseEvent& e )
 		pitch_ += dy * 0.005f;
 		pitch_ = std::clamp( pitch_, -1.3f, 1.3f );
 		m_dragging = true;
-		Refresh( false );
+		requestFrame( Redraw::Camera );
 	}
 	else if ( e.LeftUp() )
 	{
@@ -378,11 +861,20 @@ GLCanvas::onMouse( wxMouseEvent& e )
 		// screen +X is right → move center left to keep scene under cursor = subtract dx
 		const int dx = p.x - panLast_.x;
 		const int dy = p.y - panLast_.y; // +down in screen space
+		if ( dx == 0 && dy == 0 ) return;
 		camCenterX_ -= dx * worldPerPxX;
 		camCenterY_ += dy * worldPerPxY; // screen down means world up is negative Y; here we flip so drag feels natural
 
 		panLast_ = p;
-		Refresh( false );
+		requestFrame( Redraw::Camera );
+	}
+
+	if ( e.Moving() )
+		updateHover( e.GetPosition() );
+	else if ( e.Leaving() && (hoverElem_ >= 0 || hoverNode_ >= 0 || hoverEdge_ >= 0) )
+	{
+		hoverElem_ = hoverNode_ = hoverEdge_ = -1;
+		requestFrame( Redraw::Dynamic );
 	}
 
 	if ( e.GetWheelRotation() != 0 )
@@ -393,7 +885,9 @@ GLCanvas::onMouse( wxMouseEvent& e )
 
 		float steps = float( e.GetWheelRotation() ) / float( e.GetWheelDelta() );
 		float factor = std::pow( 1.1f, steps );     // 10% per wheel detent
-		camZoom_ = std::clamp( camZoom_ * factor, 0.0001f, 10000.f );
+		const float zoom = std::clamp( camZoom_ * factor, 0.0001f, 10000.f );
+		if ( zoom == camZoom_ ) return;             // at the clamp: nothing to redraw
+		camZoom_ = zoom;
 
 		// world point under cursor AFTER zoom (with same center)
 		auto after = screenToWorld( mouse.x, mouse.y );
@@ -402,27 +896,51 @@ GLCanvas::onMouse( wxMouseEvent& e )
 		camCenterX_ += (before.x - after.x);
 		camCenterY_ += (before.y - after.y);
 
-		Refresh( false );
+		requestFrame( Redraw::Camera );
 	}
 }
 
-void GLCanvas::renderScene( const Mat4& view, const Mat4& proj )
+void
+GLCanvas::updateHover( const wxPoint& p )
+{
+	if ( index_.empty() ) return;
+
+	const Vec3 wp = screenToWorld( p.x, p.y );
+	const float radius = 6.f / camZoom_; // pixels -> world
+	const int elem = index_.findElement( wp.x, wp.y );
+	const int node = index_.nearestNode( wp.x, wp.y, radius );
+	const int edge = index_.nearestEdge( wp.x, wp.y, radius );
+	if ( elem == hoverElem_ && node == hoverNode_ && edge == hoverEdge_ )
+		return;
+
+	hoverElem_ = elem; hoverNode_ = node; hoverEdge_ = edge;
+	wxLogStatus( "Element %d   Node %d   Edge %d", hoverElem_,
+				 hoverNode_ >= 0 ? int( snapshot_->ids[hoverNode_] ) : -1, hoverEdge_ );
+	requestFrame( Redraw::Dynamic );
+}
+
+void GLCanvas::renderScene( bool preview )
 {
 	glDisable( GL_CULL_FACE );          // TEMP while debugging
 	glDisable( GL_DEPTH_TEST );         // TEMP if all z==0
 
-	shader_.use();
-	shader_.setMat4( "uProj", proj.data() );
-	shader_.setMat4( "uView", view.data() );
+	// the mesh and the overlay share kMeshVS; the placeholder cube is plain kVS
+	Shader& sh = mesh_.valid() ? meshShader_ : shader_;
+	sh.use();
+	glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 1, chunkBuf_.id() );
+	glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 3, elementOfTriBuf_.id() );
+	glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 4, elementBuf_.id() );
+	glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 5, levelEdgeBuf_.id() );
+	glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 6, edgeFlagBuf_.id() );
+	sh.setUInt( "uFlagMask", uint32_t( ElementFlag::Picked ) | (showPoorElements_ ? uint32_t( ElementFlag::Poor ) : 0u) );
+	sh.setUInt( "uEdgeMask", edgeMask_ );
 	
 	// --- Triangles ---
 	{
-		const float c[4] = { triColor_.r, triColor_.g, triColor_.b, triColor_.a };
-		shader_.setVec4( "uColor", c );
+		FrameProfiler::Scope scope( profiler_, "fill" );
+		sh.setUInt( "uMaterial", GLuint( Material::Fill ) );
 		if ( mesh_.valid() )
-		{
-			mesh_.draw();
-		}
+			mesh_.drawIndirect( indirect_.id(), indirect_.offset( 0 ), fillDraws_ );
 		else
 		{
 			glBindVertexArray( vao_ );
@@ -430,25 +948,40 @@ void GLCanvas::renderScene( const Mat4& view, const Mat4& proj )
 		}
 	}
 
-	// --- Overlay (segments/arcs) ---
+	// --- Overlay (segments) ---
 	glDisable( GL_DEPTH_TEST ); // draw on top; remove if you want depth-tested edges
+	if ( !preview )
 	{
-		const float c[4] = { edgeColor_.r, edgeColor_.g, edgeColor_.b, edgeColor_.a };
-		shader_.setVec4( "uColor", c );
+		sh.setUInt( "uMaterial", GLuint( Material::Edge ) );
 
 		if ( showSegments_ && pslg_.hasSegments() )
 		{
-			pslg_.drawLines();
-		}
-		if ( showArcs_ && pslg_.hasArcs() )
-		{
-			pslg_.drawArcs();
+			FrameProfiler::Scope scope( profiler_, "segments" );
+			pslg_.drawLinesIndirect( indirect_.id(), indirect_.offset( fillDraws_ ), edgeDraws_ );
 		}
 	}
 	glEnable( GL_DEPTH_TEST );
 
 }
 
+// on top of the composited layers; not cached, it follows the cursor
+void GLCanvas::drawHover()
+{
+	if ( !mesh_.valid() || hoverElem_ < 0 || !snapshot_ ) return;
+
+	glDisable( GL_DEPTH_TEST );
+	meshShader_.use();
+	meshShader_.setUInt( "uMaterial", GLuint( Material::Hover ) );
+	glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 1, chunkBuf_.id() );
+	uint32_t first, count;
+	snapshot_->primitivesOfElement( uint32_t( hoverElem_ ), first, count );
+	// an element's triangles stay adjacent in chunk order, inside one chunk
+	const uint32_t g = chunks_.gpuOfPrim[first];
+	const uint32_t ci = chunks_.chunkOfTri( g );
+	mesh_.drawRange( GLsizei( g * 3 ), GLsizei( count * 3 ), GLint( chunks_.chunks[ci].firstVertex ), ci );
+	glEnable( GL_DEPTH_TEST );
+}
+
 void 
 GLCanvas::fitToMesh( float bboxMinX, float bboxMinY, float bboxMaxX, float bboxMaxY )
 {
@@ -486,6 +1019,29 @@ Vec3 GLCanvas::screenToWorld( int px, int py ) const
 	return { wx, wy, 0.f };
 }
 
+void
+GLCanvas::drawLabels( float left, float right, float bottom, float top, int w, int h )
+{
+	// below this many screen pixels per label the numbers overlap into noise
+	constexpr double kMinPixelsPerLabel = 400.0;
+
+	const size_t nodes = labels_.count( LabelKind::Node );
+	const size_t visibleNodes = index_.countNodesIn( left, bottom, right, top );
+	if ( nodes == 0 || visibleNodes == 0 )
+		return;
+
+	const LabelKind kinds[] = { LabelKind::Node, LabelKind::Element, LabelKind::Edge };
+	for ( LabelKind k : kinds )
+	{
+		if ( !showLabels_[int( k )] ) continue;
+		// elements/edges scale with the node density of the window
+		const double visible = double( visibleNodes ) * double( labels_.count( k ) ) / double( nodes );
+		if ( visible <= 0.0 || double( w ) * double( h ) / visible < kMinPixelsPerLabel )
+			continue;
+		labels_.draw( k, left, right, bottom, top, camZoom_ );
+	}
+}
+
 void GLCanvas::drawText2D( float x, float y, const char* text )
 {
 	// 1) Build quads from stb_easy_font (each vertex = 16 bytes)
@@ -545,11 +1101,7 @@ void GLCanvas::drawText2D( float x, float y, const char* text )
 	glDisable( GL_DEPTH_TEST );
 
 	textShader_.use();
-	int w, h; GetClientSize( &w, &h );
-	Mat4 proj = orthoPixels( float( w ), float( h ) );  // your pixel-ortho matrix
-	textShader_.setMat4( "uProj", proj.data() );
-	const float white[4] = { 1,1,1,1 };
-	textShader_.setVec4( "uColor", white );
+	textShader_.setUInt( "uMaterial", GLuint( Material::Text ) );
 
 	glBindVertexArray( vao );
 	glDrawArrays( GL_TRIANGLES, 0, (GLsizei)(verts.size() / 2) );
@@ -564,37 +1116,20 @@ void GLCanvas::drawText2D( float x, float y, const char* text )
 
 
 void 
-GLCanvas::renderPick( const Mat4& view, const Mat4& proj, int fbw, int fbh )
+GLCanvas::renderPick( int fbw, int fbh )
 {
 	if ( !mesh_.valid() ) return;
 	picker_.create( fbw, fbh );
 	picker_.begin();
 
 	pickShader_.use();
-	pickShader_.setMat4( "uProj", proj.data() );
-	pickShader_.setMat4( "uView", view.data() );
-
-	// draw each triangle with unique color id
-	glBindVertexArray( 0 ); // we’ll reuse mesh VAO but issue 3-index draws
-	glBindVertexArray( mesh_.Vao() ); // add a small getter returning mesh_.vao_ if you like
-
-	// We don’t have a public getter; simplest: add mesh_.bind() that binds the VAO.
-	// For brevity here, imagine mesh_.drawTri(i, firstIndex) – implement if desired.
-	// Minimal workable version below using glDrawElements with offset:
+	pickShader_.setUInt( "uKind", GLuint( PickKind::Triangle ) );
+	glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 1, chunkBuf_.id() );
 
-	// WARNING: requires GL 4.5+ DSA buffer addressing; here we use index offset.
-	// indices are 32-bit, so byte offset = tri*3*sizeof(uint32_t)
-	GLuint prog = pickShader_.id();
-	GLint loc = glGetUniformLocation( prog, "uId" );
-
-	// (cap number drawn if extremely large during early testing)
-	GLsizei tris = mesh_.IndexCount() / 3; // add a helper that returns count_/3
-	for ( GLsizei t = 0; t < tris; ++t )
-	{
-		glUniform1ui( loc, (GLuint)t + 1 ); // 0 = no hit
-		const void* offset = (const void*)(size_t( t ) * 3 * sizeof( uint32_t ));
-		glDrawElements( GL_TRIANGLES, 3, GL_UNSIGNED_INT, offset );
-	}
+	// culled chunks at full detail; kPickFS writes the GPU triangle index + 1
+	glDisable( GL_DEPTH_TEST );
+	mesh_.drawIndirect( indirect_.id(), indirect_.offset( size_t( fillDraws_ ) + edgeDraws_ ), exactDraws_ );
+	glEnable( GL_DEPTH_TEST );
 
 	picker_.end();
 }
@@ -1,30 +1,74 @@
 #pragma once
 #include <glad/glad.h>
 #include <wx/glcanvas.h>
+#include <wx/timer.h>
+#include <chrono>
+#include <functional>
 #include <string>
+#include <thread>
 
 #include "gl/Shader.h"
 #include "gl/Math.h"
 #include "gl/GpuMesh.h"
 #include "gl/Picker.h"
 #include "gl/PSLGOverlay.h"
+#include "gl/LabelRenderer.h"
+#include "gl/IndirectRing.h"
+#include "gl/FrameProfiler.h"
+#include "gl/FrameUniforms.h"
+#include "gl/LayerCache.h"
+#include "mesh/SpatialIndex.h"
+#include "mesh/MeshSnapshot.h"
+#include "mesh/MeshChunks.h"
+#include "gl/DisplayData.h"
 
 class GLCanvas : public wxGLCanvas
 {
 public:
 	GLCanvas( wxWindow* parent );
-	void LoadMesh( const std::string& path );
-	void RegenerateMeshDisplay();
+	~GLCanvas() override;
+	// display a snapshot built elsewhere, prepared and uploaded in this frame;
+	// only for tiny ones (the empty view). GeomBasics is not read
+	void ShowSnapshot( std::shared_ptr<const MeshSnapshot> snap, bool fit );
+	// same, for a whole new mesh: uploaded in slices over the next frames
+	// while the current one stays on screen
+	void ShowDisplay( std::shared_ptr<DisplayData> d, bool fit );
+	// result of a MeshLoadJob for 'path'; d is null when the load failed, and
+	// geometryLoaded then says whether GeomBasics was emptied on the way
+	void ShowLoadedMesh( const std::string& path, std::shared_ptr<DisplayData> d, bool geometryLoaded );
+	void SetUseMeshCache( bool b ) { useMeshCache_ = b; }
+	// 16-bit chunk-relative vertices instead of float xyz; re-prepares the current mesh
+	void SetQuantizedVertices( bool b );
+	// Morton vertex order and Tipsify triangle order; re-prepares the current mesh
+	void SetOptimizedOrder( bool b );
+	const DisplayOptions& GetDisplayOptions() const { return displayOptions_; }
 
-	void SetShowSegments( bool b ) { showSegments_ = b; Refresh( false ); }
-	void SetShowArcs( bool b ) { showArcs_ = b; Refresh( false ); }
+	// per-pass CPU/GPU timings as an overlay; CSV of every frame since enabled
+	void SetProfilerHud( bool b );
+	bool ProfilerHud() const { return profiler_.enabled(); }
+	bool ExportFrameTimings( const std::string& path ) const;
+	// called from a later frame than the click, once the id readback has
+	// landed, with the picked element or -1
+	void SetPickCallback( std::function<void( int element )> cb ) { onPick_ = std::move( cb ); }
+	bool UseMeshCache() const { return useMeshCache_; }
+	// After a cache hit GeomBasics is still empty; this hands out the deferred
+	// text load (to run on whichever thread will own the lists), or an empty
+	// function when the lists are already current
+	std::function<void()> TakeGeometryLoader();
+
+	void SetShowSegments( bool b ) { showSegments_ = b; requestFrame(); }
+	void SetShowLabels( LabelKind k, bool b ) { showLabels_[int( k )] = b; requestFrame(); }
+	// tint elements below kPoorQuality; a shader mask, nothing is re-uploaded
+	void SetShowPoorElements( bool b );
+	// edge categories (EdgeClass) to draw; also just a shader mask
+	void SetShowEdgeClass( EdgeClass c, bool b );
 	void SetTriangleColor( float r, float g, float b, float a = 1.0f )
 	{
-		triColor_ = { r,g,b,a }; Refresh( false );
+		triColor_ = { r,g,b,a }; requestFrame();
 	}
 	void SetEdgeColor( float r, float g, float b, float a = 1.0f )
 	{
-		edgeColor_ = { r,g,b,a }; Refresh( false );
+		edgeColor_ = { r,g,b,a }; requestFrame();
 	}
 
 	struct Color { float r{ 0.90f }, g{ 0.85f }, b{ 0.10f }, a{ 1.0f }; };
@@ -41,10 +85,22 @@ private:
 	// GPU objects
 	GLuint vao_ = 0, vbo_ = 0, ibo_ = 0;
 	Shader shader_;
+	Shader meshShader_;     // kMeshVS: decodes positions through the chunk table
+	PersistentBuffer chunkBuf_;     // ChunkInfo per chunk, SSBO binding 1
+	PersistentBuffer elementOfTriBuf_;  // exact GPU triangle -> element, SSBO binding 3
+	PersistentBuffer elementBuf_;   // ElementAttrib per element, SSBO binding 4
+	PersistentBuffer levelEdgeBuf_; // firstEdge per LOD level, SSBO binding 5
+	PersistentBuffer edgeFlagBuf_;  // EdgeClass bits per GPU edge, 4 per uint, SSBO binding 6
+	std::vector<ElementAttrib> elements_;   // what elementBuf_ holds
+	void setElementFlag( int elem, ElementFlag flag, bool on );
 	GpuMesh mesh_;
 	Picker  picker_;
 	Shader  pickShader_;
 	Shader  textShader_;
+	FrameUniformBuffer frame_;  // camera + palette, uniform binding 0
+	LayerCache layers_;         // fill, overlay and labels around the view
+	LabelRenderer labels_;
+	FrameProfiler profiler_;
 
 	// camera
 	float yaw_ = 0.6f, pitch_ = 0.3f, dist_ = 3.0f;
@@ -59,27 +115,93 @@ private:
 
 	bool m_dragging = false;
 	
+	// Frame scheduling: changes ask for a frame instead of calling Refresh,
+	// requests coalesce into at most one frame per kFrameIntervalMs, and
+	// while the camera moves frames are previews (no labels, no overlay)
+	// until kRefineDelayMs after the last camera change. Scene means the
+	// cached layers are stale; Dynamic only touches what is drawn over them.
+	enum class Redraw { Scene, Camera, Dynamic };
+	void requestFrame( Redraw why = Redraw::Scene );
+	void onFrameTimer( wxTimerEvent& );
+	static constexpr double kFrameIntervalMs = 16.0;
+	static constexpr double kRefineDelayMs = 150.0;
+	wxTimer frameTimer_;
+	bool frameRequested_ = false;   // a Refresh, or the timer for one, is on its way
+	bool previewShown_ = false;     // the last frame needs refining
+	std::chrono::steady_clock::time_point lastFrame_, lastCameraChange_;
+
 	bool wantPick_ = false;
 	wxPoint pickPos_{ 0,0 };
-	int pickedTri_ = -1;
+	int pickedElem_ = -1;
+	std::chrono::steady_clock::time_point pickClicked_;
+	uint64_t displayGeneration_ = 0;    // bumped per adopted mesh; tags pick reads
+	std::function<void( int )> onPick_;
+	void resolvePicks();
+
+	// CPU-side hover queries, adopted with every displayed snapshot
+	SpatialIndex index_;
+	std::shared_ptr<const MeshSnapshot> snapshot_;  // what is on screen
+	void stepUpload();
+	void cancelUpload();
+	void adoptDisplay( DisplayData& d, bool fit );
+	static constexpr size_t kUploadSliceBytes = 4u << 20;
+	static constexpr double kUploadBudgetMs = 4.0;  // per frame
+	std::shared_ptr<DisplayData> incoming_;         // being staged, not yet shown
+	bool incomingFit_ = false;
+	bool firstFramePending_ = false;    // trace marker for the next SwapBuffers
+
+	// view-frustum culling: visible chunks -> indirect draw commands
+	void cullChunks( float left, float right, float bottom, float top, bool exact );
+	static constexpr float kLodErrorPx = 1.0f;     // allowed LOD vertex displacement on screen
+	// baseInstance: chunk index, and above kSlotShift the selectSlot() drawn (0 = exact)
+	static constexpr GLuint kSlotShift = 24;
+	MeshChunks chunks_;
+	IndirectRing indirect_;
+	std::vector<uint32_t> visibleChunks_;
+	GLsizei fillDraws_ = 0, edgeDraws_ = 0, exactDraws_ = 0;
+	size_t visibleTris_ = 0;
+	bool useMeshCache_ = true;
+	DisplayOptions displayOptions_;
+	void setDisplayOptions( const DisplayOptions& o );
+	// DisplayData::prepare for the shown snapshot in the current layout, on a
+	// worker; one at a time, and a stale result is redone or dropped
+	void prepareDisplay();
+	void preparedDisplay( std::shared_ptr<DisplayData> d );
+	std::thread prepareThread_;
+	bool preparing_ = false;
+	std::string pendingGeometry_;   // mesh shown from cache, not yet in GeomBasics
+	int hoverElem_ = -1, hoverNode_ = -1, hoverEdge_ = -1;
 	PSLGOverlay pslg_;
 	bool showSegments_ = true;
-	bool showArcs_ = true;
 
 	// GLCanvas.h (add near other members)
 	
 	Color triColor_{ 0.45f, 0.8f, 0.85f, 1.0f };
 	Color edgeColor_{ 0.15f, 0.45f, 0.5f, 1.0f };
+	Color hoverColor_{ 1.0f, 0.6f, 0.15f, 1.0f };
+	Color pickedColor_{ 0.95f, 0.25f, 0.3f, 1.0f };
+	Color poorColor_{ 0.55f, 0.2f, 0.75f, 1.0f };
+	bool showPoorElements_ = false;
+	uint32_t edgeMask_ = uint32_t( EdgeClass::All );
+	bool showLabels_[int( LabelKind::Count )] = { true, false, false };
+	Color labelColors_[int( LabelKind::Count )] = {
+		{ 1.0f, 1.0f, 1.0f, 1.0f },     // nodes
+		{ 1.0f, 0.9f, 0.4f, 1.0f },     // elements
+		{ 0.6f, 0.9f, 1.0f, 1.0f } };   // edges
 
-	void renderScene( const Mat4& view, const Mat4& proj );
-	void renderPick( const Mat4& view, const Mat4& proj, int fbw, int fbh );
+	void renderScene( bool preview );
+	void drawHover();
+	void updateFrameUniforms( const LayerCache::Window& window, int w, int h );
+	void renderPick( int fbw, int fbh );
 	Vec3 screenToWorld( int px, int py ) const;
 	void fitToMesh( float bboxMinX, float bboxMinY, float bboxMaxX, float bboxMaxY );
 	void drawText2D( float x, float y, const char* text );
+	void drawLabels( float left, float right, float bottom, float top, int w, int h );
 
 	void createPipeline();
 	void destroyPipeline();
 	void onMouse( wxMouseEvent& e );
+	void updateHover( const wxPoint& p );
 
 	wxDECLARE_EVENT_TABLE();
 };
\ No newline at end of file
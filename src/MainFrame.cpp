@@ -1,18 +1,36 @@
 #include "MainFrame.h"
 #include "GLCanvas.h"
+#include "mesh/Trace.h"
 #include <wx/menu.h>
 #include <wx/filedlg.h>
 #include <wx/sizer.h>
 #include <wx/colordlg.h>
 
-#include "QMorph.h"
 
 wxBEGIN_EVENT_TABLE( MainFrame, wxFrame )
     EVT_MENU( ID_Open, MainFrame::OnOpen )
+    EVT_MENU( ID_UseCache, MainFrame::OnUseCache )
+    EVT_MENU( ID_CancelLoad, MainFrame::OnCancelLoad )
     EVT_MENU( ID_SetTriColor, MainFrame::OnSetTriColor )
     EVT_MENU( ID_SetEdgeColor, MainFrame::OnSetEdgeColor )
     EVT_MENU( ID_ToggleEdges, MainFrame::OnToggleEdges )
+    EVT_MENU( ID_BoundaryEdges, MainFrame::OnEdgeClass )
+    EVT_MENU( ID_InteriorEdges, MainFrame::OnEdgeClass )
+    EVT_MENU( ID_FrontEdges, MainFrame::OnEdgeClass )
+    EVT_MENU( ID_PoorElements, MainFrame::OnPoorElements )
+    EVT_MENU( ID_CompactVertices, MainFrame::OnCompactVertices )
+    EVT_MENU( ID_OptimizeOrder, MainFrame::OnOptimizeOrder )
+    EVT_MENU( ID_ProfilerHud, MainFrame::OnProfilerHud )
+    EVT_MENU( ID_ExportTimings, MainFrame::OnExportTimings )
+    EVT_MENU( ID_RecordTrace, MainFrame::OnRecordTrace )
+    EVT_MENU( ID_SaveTrace, MainFrame::OnSaveTrace )
+    EVT_MENU( ID_NodeLabels, MainFrame::OnToggleLabels )
+    EVT_MENU( ID_ElementLabels, MainFrame::OnToggleLabels )
+    EVT_MENU( ID_EdgeLabels, MainFrame::OnToggleLabels )
     EVT_MENU( ID_QMorph, MainFrame::OnQMorph )
+    EVT_MENU( ID_QMorphPause, MainFrame::OnQMorphPause )
+    EVT_MENU( ID_QMorphCancel, MainFrame::OnQMorphCancel )
+    EVT_CLOSE( MainFrame::OnClose )
 wxEND_EVENT_TABLE()
 
 MainFrame::MainFrame()
@@ -20,6 +38,9 @@ MainFrame::MainFrame()
 {
   auto* menuFile = new wxMenu;
   menuFile->Append(ID_Open, "&Open...\tCtrl+O");
+  menuFile->AppendCheckItem(ID_UseCache, "Use Mesh &Cache", "Reopen meshes from a binary .qmvc file next to them");
+  menuFile->Check(ID_UseCache, true);
+  menuFile->Append(ID_CancelLoad, "Cancel &Load\tEsc", "Stop the mesh load at its next phase");
   menuFile->AppendSeparator();
   menuFile->Append(wxID_EXIT, "E&xit");
   auto* menuBar = new wxMenuBar;
@@ -29,14 +50,32 @@ MainFrame::MainFrame()
   mView->Append( ID_SetTriColor, "Set &Triangle Color..." );
   mView->Append( ID_SetEdgeColor, "Set &Edge Color..." );
   mView->AppendCheckItem( ID_ToggleEdges, "Show &Edges" )->Check( true );
+  mView->AppendCheckItem( ID_BoundaryEdges, "&Boundary Edges", "Edges on the side of only one element" )->Check( true );
+  mView->AppendCheckItem( ID_InteriorEdges, "Interior Ed&ges", "Edges shared by two elements" )->Check( true );
+  mView->AppendCheckItem( ID_FrontEdges, "&Front Edges", "Edges on the QMorph front" )->Check( true );
+  mView->AppendCheckItem( ID_PoorElements, "Highlight Poor &Quality Elements", "Tint elements whose smallest angle is under half the ideal" );
+  mView->AppendCheckItem( ID_CompactVertices, "&Compact Vertices (16-bit)", "Store positions as 16 bits relative to each chunk" );
+  mView->AppendCheckItem( ID_OptimizeOrder, "&Optimize Vertex Order", "Morton-ordered vertices and vertex-cache-friendly triangles" );
+  mView->AppendSeparator();
+  mView->AppendCheckItem( ID_NodeLabels, "&Node Numbers" )->Check( true );
+  mView->AppendCheckItem( ID_ElementLabels, "Ele&ment IDs" );
+  mView->AppendCheckItem( ID_EdgeLabels, "Edge &IDs" );
+  mView->AppendSeparator();
+  mView->AppendCheckItem( ID_ProfilerHud, "Frame &Profiler\tF3", "Per-pass CPU and GPU times on screen" );
+  mView->Append( ID_ExportTimings, "E&xport Frame Timings...", "Write the profiled frames as CSV" );
+  mView->AppendCheckItem( ID_RecordTrace, "&Record Trace", "Record load, QMorph and upload phases from now on" )->Check( Trace::enabled() );
+  mView->Append( ID_SaveTrace, "Save T&race...", "Write the recorded phases as Chrome trace JSON (Perfetto)" );
   menuBar->Append( mView, "&View" );
 
   auto* mMesh = new wxMenu;
   mMesh->Append( ID_QMorph, "&QMorph" );
+  mMesh->AppendCheckItem( ID_QMorphPause, "&Pause", "Hold QMorph at its next checkpoint" );
+  mMesh->Append( ID_QMorphCancel, "&Cancel", "Stop QMorph at its next checkpoint" );
   menuBar->Append( mMesh, "&Mesh" );
 
   SetMenuBar(menuBar);
   CreateStatusBar();
+  SetBusy( false );
 
   canvas_ = new GLCanvas(this);
   auto* sizer = new wxBoxSizer(wxVERTICAL);
@@ -47,13 +86,38 @@ MainFrame::MainFrame()
 void MainFrame::OnOpen(wxCommandEvent&) {
   wxFileDialog dlg(this, "Open mesh", "", "", "Meshes (*.mesh)|*.mesh|All files|*.*",
                    wxFD_OPEN | wxFD_FILE_MUST_EXIST);
-  if (dlg.ShowModal() == wxID_OK) {
-    canvas_->LoadMesh(std::string(dlg.GetPath().ToUTF8()));
-  }
+  if (dlg.ShowModal() != wxID_OK || (load_ && load_->running())) return;
+
+  // the current mesh stays up until the new one is fully on the GPU
+  Trace::instant( "Open" );
+  const std::string path(dlg.GetPath().ToUTF8());
+  MeshLoadJob::Callbacks cb;
+  cb.progress = [this]( const std::string& phase )
+      {
+          CallAfter( [this, phase] { SetStatusText( phase ); } );
+      };
+  cb.finished = [this, path]( std::shared_ptr<DisplayData> d, bool geometryLoaded, bool )
+      {
+          CallAfter( [this, path, d, geometryLoaded]
+                     {
+                         load_.reset();
+                         if ( closing_ ) { Close(); return; }
+                         canvas_->ShowLoadedMesh( path, d, geometryLoaded );
+                         SetBusy( false );
+                     } );
+      };
+
+  load_ = std::make_unique<MeshLoadJob>( std::filesystem::path( dlg.GetPath().ToStdWstring() ), canvas_->UseMeshCache(), canvas_->GetDisplayOptions(), std::move( cb ) );
+  SetBusy( true );
+  load_->start();
 }
 
+void MainFrame::OnCancelLoad(wxCommandEvent&) { if (load_) load_->cancel(); }
+
 void MainFrame::OnQuit(wxCommandEvent&) { Close(true); }
 
+void MainFrame::OnUseCache(wxCommandEvent& e) { canvas_->SetUseMeshCache(e.IsChecked()); }
+
 static inline void ApplyColorDialog( wxWindow* parent,
                                      std::function<void( float, float, float, float )> setter,
                                      const wxColour& initial = *wxWHITE )
@@ -92,12 +156,158 @@ MainFrame::OnToggleEdges( wxCommandEvent& e )
     canvas_->SetShowSegments( e.IsChecked() );
 }
 
+void
+MainFrame::OnEdgeClass( wxCommandEvent& e )
+{
+    const EdgeClass c = e.GetId() == ID_BoundaryEdges ? EdgeClass::Boundary
+                      : e.GetId() == ID_InteriorEdges ? EdgeClass::Interior
+                      : EdgeClass::Front;
+    canvas_->SetShowEdgeClass( c, e.IsChecked() );
+}
+
+void
+MainFrame::OnPoorElements( wxCommandEvent& e )
+{
+    canvas_->SetShowPoorElements( e.IsChecked() );
+}
+
+void
+MainFrame::OnCompactVertices( wxCommandEvent& e )
+{
+    canvas_->SetQuantizedVertices( e.IsChecked() );
+}
+
+void
+MainFrame::OnOptimizeOrder( wxCommandEvent& e )
+{
+    canvas_->SetOptimizedOrder( e.IsChecked() );
+}
+
+void
+MainFrame::OnProfilerHud( wxCommandEvent& e )
+{
+    canvas_->SetProfilerHud( e.IsChecked() );
+}
+
+void
+MainFrame::OnExportTimings( wxCommandEvent& )
+{
+    wxFileDialog dlg( this, "Export frame timings", "", "frames.csv", "CSV (*.csv)|*.csv",
+                      wxFD_SAVE | wxFD_OVERWRITE_PROMPT );
+    if ( dlg.ShowModal() != wxID_OK ) return;
+    if ( !canvas_->ExportFrameTimings( std::string( dlg.GetPath().ToUTF8() ) ) )
+        wxLogError( "Could not write %s", dlg.GetPath() );
+}
+
+void
+MainFrame::OnRecordTrace( wxCommandEvent& e )
+{
+    Trace::setEnabled( e.IsChecked() );
+}
+
+void
+MainFrame::OnSaveTrace( wxCommandEvent& )
+{
+    wxFileDialog dlg( this, "Save trace", "", "qmvision.trace.json", "Chrome trace (*.json)|*.json",
+                      wxFD_SAVE | wxFD_OVERWRITE_PROMPT );
+    if ( dlg.ShowModal() != wxID_OK ) return;
+    if ( !Trace::write( std::string( dlg.GetPath().ToUTF8() ) ) )
+        wxLogError( "Could not write %s", dlg.GetPath() );
+}
+
+void
+MainFrame::OnToggleLabels( wxCommandEvent& e )
+{
+    const LabelKind kind = e.GetId() == ID_NodeLabels ? LabelKind::Node
+                         : e.GetId() == ID_ElementLabels ? LabelKind::Element
+                         : LabelKind::Edge;
+    canvas_->SetShowLabels( kind, e.IsChecked() );
+}
+
 void 
 MainFrame::OnQMorph( wxCommandEvent& )
 {
-    auto Morph = std::make_shared<QMorph>();
-    Morph->init( -1, 0.6, false );
-    Morph->run();
+    if ( qmorph_ && qmorph_->running() ) return;
+    Trace::instant( "QMorph" );
 
-    canvas_->RegenerateMeshDisplay();
+    // worker callbacks arrive off the UI thread; bounce everything through CallAfter
+    QMorphJob::Callbacks cb;
+    cb.prepare = canvas_->TakeGeometryLoader();
+    cb.progress = [this]( const std::string& phase )
+        {
+            CallAfter( [this, phase] { SetStatusText( phase ); } );
+        };
+    cb.published = [this]
+        {
+            CallAfter( [this]
+                       {
+                           if ( closing_ ) return;
+                           if ( auto d = snapshots_.take() )
+                               canvas_->ShowDisplay( d, false );
+                       } );
+        };
+    cb.finished = [this]( bool )
+        {
+            CallAfter( [this]
+                       {
+                           qmorph_.reset();
+                           if ( closing_ ) { Close(); return; }
+                           if ( auto d = snapshots_.take() )
+                               canvas_->ShowDisplay( d, false );
+                           SetBusy( false );
+                       } );
+        };
+
+    qmorph_ = std::make_unique<QMorphJob>( snapshots_, canvas_->GetDisplayOptions(), std::move( cb ) );
+    SetBusy( true );
+    qmorph_->start();
+}
+
+void
+MainFrame::OnQMorphPause( wxCommandEvent& e )
+{
+    if ( qmorph_ ) qmorph_->setPaused( e.IsChecked() );
+}
+
+void
+MainFrame::OnQMorphCancel( wxCommandEvent& )
+{
+    if ( qmorph_ ) qmorph_->cancel();
+}
+
+void
+MainFrame::OnClose( wxCloseEvent& e )
+{
+    // the workers may be deep inside a phase; joining them here would freeze
+    // the window until it returns. Ask them to stop, hide, and close for real
+    // from their finished callbacks.
+    if ( load_ ) load_->cancel();
+    if ( qmorph_ ) qmorph_->cancel();
+    const bool busy = (load_ && load_->running()) || (qmorph_ && qmorph_->running());
+    if ( busy && e.CanVeto() )
+    {
+        closing_ = true;
+        Hide();
+        e.Veto();
+        return;
+    }
+    load_.reset();
+    qmorph_.reset();
+    e.Skip();
+}
+
+void
+MainFrame::SetBusy( bool busy )
+{
+    // while a job owns GeomBasics nothing else may touch the lists
+    auto* mb = GetMenuBar();
+    mb->Enable( ID_Open, !busy );
+    mb->Enable( ID_UseCache, !busy );
+    mb->Enable( ID_CompactVertices, !busy );
+    mb->Enable( ID_OptimizeOrder, !busy );
+    mb->Enable( ID_QMorph, !busy );
+    mb->Enable( ID_QMorphPause, busy && qmorph_ );
+    mb->Enable( ID_QMorphCancel, busy && qmorph_ );
+    mb->Enable( ID_CancelLoad, busy && load_ );
+    if ( !busy ) mb->Check( ID_QMorphPause, false );
 }
@@ -1,6 +1,10 @@
 #pragma once
 #include <wx/frame.h>
 #include "GLCanvas.h"
+#include "QMorphJob.h"
+#include "MeshLoadJob.h"
+
+#include <memory>
 
 class MainFrame : public wxFrame
 {
@@ -10,18 +14,50 @@ private:
 	enum
 	{
 		ID_Open = wxID_HIGHEST + 1,
+		ID_UseCache,
+		ID_CancelLoad,
 		ID_SetTriColor,
 		ID_SetEdgeColor,
 		ID_ToggleEdges,
-		ID_QMorph
+		ID_BoundaryEdges,
+		ID_InteriorEdges,
+		ID_FrontEdges,
+		ID_PoorElements,
+		ID_CompactVertices,
+		ID_OptimizeOrder,
+		ID_ProfilerHud,
+		ID_ExportTimings,
+		ID_RecordTrace,
+		ID_SaveTrace,
+		ID_NodeLabels,
+		ID_ElementLabels,
+		ID_EdgeLabels,
+		ID_QMorph,
+		ID_QMorphPause,
+		ID_QMorphCancel
 	};
 
 	void OnOpen( wxCommandEvent& );
 	void OnQuit( wxCommandEvent& );
+	void OnUseCache( wxCommandEvent& );
+	void OnCancelLoad( wxCommandEvent& );
 	void OnSetTriColor( wxCommandEvent& );
 	void OnSetEdgeColor( wxCommandEvent& );
 	void OnToggleEdges( wxCommandEvent& );
+	void OnEdgeClass( wxCommandEvent& );
+	void OnPoorElements( wxCommandEvent& );
+	void OnCompactVertices( wxCommandEvent& );
+	void OnOptimizeOrder( wxCommandEvent& );
+	void OnProfilerHud( wxCommandEvent& );
+	void OnExportTimings( wxCommandEvent& );
+	void OnRecordTrace( wxCommandEvent& );
+	void OnSaveTrace( wxCommandEvent& );
+	void OnToggleLabels( wxCommandEvent& );
 	void OnQMorph( wxCommandEvent& );
+	void OnQMorphPause( wxCommandEvent& );
+	void OnQMorphCancel( wxCommandEvent& );
+	void OnClose( wxCloseEvent& );
+	void SetBusy( bool busy );
 
 	inline wxColour ToWx( GLCanvas::Color c )
 	{
@@ -40,5 +76,13 @@ private:
 	}
 
 	GLCanvas* canvas_{};
+
+	// background mesh load; owns GeomBasics while it runs
+	std::unique_ptr<MeshLoadJob> load_;
+
+	// background QMorph; owns GeomBasics while it runs
+	SnapshotExchange snapshots_;
+	std::unique_ptr<QMorphJob> qmorph_;
+	bool closing_ = false;          // close requested; waiting for the workers to stop
 	wxDECLARE_EVENT_TABLE();
 };
\ No newline at end of file
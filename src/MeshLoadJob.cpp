@@ -0,0 +1,68 @@
+// MeshLoadJob.cpp
+#include "MeshLoadJob.h"
+
+#include "mesh/MeshLoader.h"
+#include "mesh/Trace.h"
+
+#include <GeomBasics.h>
+
+#include <exception>
+
+MeshLoadJob::MeshLoadJob( std::filesystem::path path, bool useCache, DisplayOptions display, Callbacks cb )
+    : path_( std::move( path ) ), useCache_( useCache ), display_( display ), cb_( std::move( cb ) )
+{
+}
+
+MeshLoadJob::~MeshLoadJob()
+{
+    cancel();
+    if ( thread_.joinable() ) thread_.join();
+}
+
+void MeshLoadJob::start()
+{
+    if ( running_ ) return;
+    if ( thread_.joinable() ) thread_.join();
+    cancel_ = false;
+    running_ = true;
+    thread_ = std::thread( [this] { threadMain(); } );
+}
+
+void MeshLoadJob::cancel()
+{
+    cancel_ = true;
+}
+
+void MeshLoadJob::threadMain()
+{
+    Trace::setThreadName( "MeshLoadJob" );
+    Trace::Scope trace( "MeshLoadJob" );
+    const std::string name = path_.filename().string();
+    auto checkpoint = [&]( const std::string& phase )
+        {
+            if ( cb_.progress ) cb_.progress( phase + ": " + name );
+            return !cancel_;
+        };
+
+    std::shared_ptr<DisplayData> display;
+    MeshLoader::Result r;
+    try
+    {
+        r = MeshLoader::load( path_, useCache_, checkpoint );
+        if ( !r.error.empty() && cb_.progress ) cb_.progress( "Load failed: " + r.error );
+        // once GeomBasics holds the new mesh it has to be shown, cancelled or not
+        if ( r.snapshot && (checkpoint( "Preparing display" ) || r.geometryLoaded) )
+            display = DisplayData::prepare( r.snapshot, display_ );
+    }
+    catch ( const std::exception& e )
+    {
+        // the lists cannot be shown any more either; MainFrame clears the view
+        if ( r.geometryLoaded ) GeomBasics::clearLists();
+        if ( cb_.progress ) cb_.progress( std::string( "Load failed: " ) + e.what() );
+    }
+    const bool cancelled = !display && cancel_;
+
+    running_ = false;
+    if ( cb_.progress && cancelled ) cb_.progress( "Load cancelled" );
+    if ( cb_.finished ) cb_.finished( std::move( display ), r.geometryLoaded, cancelled );
+}
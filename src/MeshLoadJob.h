@@ -0,0 +1,44 @@
+#pragma once
+#include <atomic>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "gl/DisplayData.h"
+
+// Opens a mesh on a worker thread: cache or text parse, GeomBasics rebuild,
+// snapshot extraction and the CPU side of the display (DisplayData). The UI
+// keeps drawing the previous mesh meanwhile. On a cache miss the worker
+// replaces the GeomBasics lists, so nothing else may run on them until
+// finished fires. Callbacks fire on the worker thread; marshal them to the UI.
+class MeshLoadJob
+{
+public:
+	struct Callbacks
+	{
+		std::function<void( const std::string& phase )> progress;
+		// display is null when the load failed or was cancelled
+		std::function<void( std::shared_ptr<DisplayData> display, bool geometryLoaded, bool cancelled )> finished;
+	};
+
+	MeshLoadJob( std::filesystem::path path, bool useCache, DisplayOptions display, Callbacks cb );
+	~MeshLoadJob();                 // cancels and joins
+
+	void start();
+	void cancel();                  // honoured at the next phase boundary
+	bool running() const { return running_; }
+	const std::filesystem::path& path() const { return path_; }
+
+private:
+	void threadMain();
+
+	std::filesystem::path path_;
+	bool useCache_;
+	DisplayOptions display_;
+	Callbacks cb_;
+	std::thread thread_;
+	std::atomic<bool> running_{ false };
+	std::atomic<bool> cancel_{ false };
+};
@@ -0,0 +1,119 @@
+// QMorphJob.cpp
+#include "QMorphJob.h"
+
+#include "QMorph.h"
+#include "mesh/Trace.h"
+
+#include <chrono>
+#include <cstdio>
+
+QMorphJob::QMorphJob( SnapshotExchange& out, DisplayOptions display, Callbacks cb )
+    : out_( out ), display_( display ), cb_( std::move( cb ) )
+{
+}
+
+QMorphJob::~QMorphJob()
+{
+    cancel();
+    if ( thread_.joinable() ) thread_.join();
+}
+
+void QMorphJob::start()
+{
+    if ( running_ ) return;
+    if ( thread_.joinable() ) thread_.join();
+    cancel_ = false;
+    running_ = true;
+    thread_ = std::thread( [this] { threadMain(); } );
+}
+
+void QMorphJob::cancel()
+{
+    cancel_ = true;
+    setPaused( false );
+}
+
+void QMorphJob::setPaused( bool p )
+{
+    {
+        std::lock_guard lock( m_ );
+        paused_ = p;
+    }
+    cv_.notify_all();
+}
+
+bool QMorphJob::checkpoint( const char* phase )
+{
+    if ( cb_.progress ) cb_.progress( paused_ ? std::string( phase ) + " (paused)" : phase );
+    std::unique_lock lock( m_ );
+    cv_.wait( lock, [this] { return !paused_ || cancel_; } );
+    return !cancel_;
+}
+
+void QMorphJob::publish()
+{
+    Trace::Scope trace( "QMorphJob::publish" );
+    // a snapshot is the whole mesh: prepare it here, the UI only streams it up
+    out_.publish( DisplayData::prepare( MeshSnapshot::extract(), display_ ) );
+    if ( cb_.published ) cb_.published();
+}
+
+void QMorphJob::runPhase( const char* phase, const std::function<void()>& fn )
+{
+    Trace::Scope trace( phase );
+    std::mutex m;
+    std::condition_variable cv;
+    bool done = false;
+    const auto t0 = std::chrono::steady_clock::now();
+    std::thread ticker( [&]
+                        {
+                            std::unique_lock lock( m );
+                            while ( !cv.wait_for( lock, std::chrono::milliseconds( kProgressMs ), [&] { return done; } ) )
+                            {
+                                const double s = std::chrono::duration<double>( std::chrono::steady_clock::now() - t0 ).count();
+                                char text[160];
+                                std::snprintf( text, sizeof( text ), "%s, %.1f s%s", phase, s,
+                                               cancel_ ? " (cancelling)" : paused_ ? " (pausing)" : "" );
+                                if ( cb_.progress ) cb_.progress( text );
+                            }
+                        } );
+    fn();
+    {
+        std::lock_guard lock( m );
+        done = true;
+    }
+    cv.notify_all();
+    ticker.join();
+}
+
+void QMorphJob::threadMain()
+{
+    // QMorph::init() and run() have no intermediate hook and must not be read
+    // from while they work: snapshots go out at the phase boundaries, a ticker
+    // reports progress inside each phase, and pause/cancel are acknowledged at
+    // once and take effect when the phase returns
+    Trace::setThreadName( "QMorphJob" );
+    Trace::Scope trace( "QMorphJob" );
+    bool cancelled = true;
+    if ( cb_.prepare )
+    {
+        // mesh was opened from the cache; QMorph needs the real lists
+        runPhase( "Loading geometry", cb_.prepare );
+    }
+    auto morph = std::make_shared<QMorph>();
+    if ( checkpoint( "QMorph: init" ) )
+    {
+        runPhase( "QMorph: init", [&] { morph->init( -1, 0.6, false ); } );
+        if ( !cancel_ ) publish();
+        if ( checkpoint( "QMorph: running" ) )
+        {
+            runPhase( "QMorph: running", [&] { morph->run(); } );
+            cancelled = cancel_;
+        }
+    }
+    publish();      // GeomBasics and the view must agree, cancelled or not
+
+    running_ = false;
+    if ( cb_.progress ) cb_.progress( cancelled ? "QMorph cancelled" : "QMorph done" );
+    if ( cb_.finished ) cb_.finished( cancelled );
+}
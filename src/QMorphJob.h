@@ -0,0 +1,54 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "gl/DisplayData.h"
+#include "mesh/SnapshotExchange.h"
+
+// Runs QMorph on a worker thread. While the job is alive the worker owns the
+// GeomBasics lists: the UI must only look at the snapshots it publishes, each
+// already prepared for display with the given options.
+// Callbacks fire on the worker thread; marshal them to the UI (CallAfter).
+class QMorphJob
+{
+public:
+	struct Callbacks
+	{
+		std::function<void()> prepare;              // optional, first thing on the worker
+		std::function<void( const std::string& phase )> progress;
+		std::function<void()> published;            // new display in the exchange
+		std::function<void( bool cancelled )> finished;
+	};
+
+	QMorphJob( SnapshotExchange& out, DisplayOptions display, Callbacks cb );
+	~QMorphJob();                   // cancels and joins
+
+	void start();
+	void cancel();                  // honoured at the next checkpoint; never blocks
+	void setPaused( bool p );       // blocks the worker at the next checkpoint
+	bool paused() const { return paused_; }
+	bool running() const { return running_; }
+
+private:
+	void threadMain();
+	bool checkpoint( const char* phase );   // false when cancelled
+	void publish();
+	// runs fn on this thread while reporting progress every kProgressMs
+	void runPhase( const char* phase, const std::function<void()>& fn );
+
+	static constexpr int kProgressMs = 250;
+
+	SnapshotExchange& out_;
+	DisplayOptions display_;
+	Callbacks cb_;
+	std::thread thread_;
+	std::atomic<bool> running_{ false };
+	std::atomic<bool> cancel_{ false };
+	std::atomic<bool> paused_{ false };
+	std::mutex m_;
+	std::condition_variable cv_;
+};
@@ -0,0 +1,117 @@
+// DisplayData.cpp
+#include "DisplayData.h"
+#include "../mesh/Trace.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+namespace
+{
+    // smallest interior angle of the polygon, radians
+    double minAngle( const MeshSnapshot& s, const uint32_t* c, int n )
+    {
+        double m = 3.14159265358979;
+        for ( int i = 0; i < n; ++i )
+        {
+            const uint32_t p = c[(i + n - 1) % n], v = c[i], q = c[(i + 1) % n];
+            const double ax = s.x[p] - s.x[v], ay = s.y[p] - s.y[v];
+            const double bx = s.x[q] - s.x[v], by = s.y[q] - s.y[v];
+            m = std::min( m, std::abs( std::atan2( ax * by - ay * bx, ax * bx + ay * by ) ) );
+        }
+        return m;
+    }
+}
+
+std::shared_ptr<DisplayData> DisplayData::prepare( std::shared_ptr<const MeshSnapshot> snap, DisplayOptions options )
+{
+    Trace::Scope trace( "DisplayData::prepare" );
+    auto d = std::make_shared<DisplayData>();
+    d->options = options;
+    if ( !snap ) return d;
+    const MeshSnapshot& s = *snap;
+
+    {
+        Trace::Scope traceChunks( "MeshChunks::build" );
+        d->chunks.build( s );
+    }
+    if ( options.reorder )
+    {
+        Trace::Scope traceOrder( "MeshChunks::reorder" );
+        d->chunks.reorder( s );
+    }
+    if ( options.quantized )
+    {
+        Trace::Scope traceLocal( "MeshChunks::localize" );
+        d->chunks.localize( s );
+    }
+    else if ( !d->chunks.reordered() )
+        d->positions = s.positions();
+    else
+    {
+        d->positions.resize( s.nodeCount() * 3 );
+        for ( size_t v = 0; v < s.nodeCount(); ++v )
+        {
+            const uint32_t n = d->chunks.nodeOfVertex[v];
+            d->positions[v * 3 + 0] = float( s.x[n] );
+            d->positions[v * 3 + 1] = float( s.y[n] );
+            d->positions[v * 3 + 2] = 0.0f;
+        }
+    }
+
+    // node numbers at the nodes, element/edge ids at centroids/midpoints
+    auto& out = d->labels;
+    out.reserve( s.nodeCount() + s.elementCount() + s.edgeCount() );
+    for ( size_t i = 0; i < s.nodeCount(); ++i )
+        out.push_back( { float( s.x[i] ), float( s.y[i] ), s.ids[i] } );
+    for ( size_t t = 0; t < s.triCount(); ++t )
+    {
+        const uint32_t* c = &s.tris[t * 3];
+        out.push_back( { float( (s.x[c[0]] + s.x[c[1]] + s.x[c[2]]) / 3.0 ),
+                         float( (s.y[c[0]] + s.y[c[1]] + s.y[c[2]]) / 3.0 ),
+                         uint32_t( t ) } );
+    }
+    for ( size_t q = 0; q < s.quadCount(); ++q )
+    {
+        const uint32_t* c = &s.quads[q * 4];
+        out.push_back( { float( (s.x[c[0]] + s.x[c[1]] + s.x[c[2]] + s.x[c[3]]) / 4.0 ),
+                         float( (s.y[c[0]] + s.y[c[1]] + s.y[c[2]] + s.y[c[3]]) / 4.0 ),
+                         uint32_t( s.triCount() + q ) } );
+    }
+    for ( size_t i = 0; i < s.edgeCount(); ++i )
+    {
+        const uint32_t a = s.edges[i * 2], b = s.edges[i * 2 + 1];
+        out.push_back( { float( 0.5 * (s.x[a] + s.x[b]) ), float( 0.5 * (s.y[a] + s.y[b]) ), uint32_t( i ) } );
+    }
+    const size_t counts[] = { s.nodeCount(), s.elementCount(), s.edgeCount() };
+    for ( size_t k = 0, first = 0; k < std::size( counts ); first += counts[k++] )
+        d->labelGrids[k] = LabelGrid::build( out.data() + first, counts[k],
+                                             float( s.minX ), float( s.minY ), float( s.maxX ), float( s.maxY ) );
+
+    // element state for the fill shader: quality now, highlights later
+    {
+        Trace::Scope traceElements( "DisplayData::elements" );
+        constexpr double kTriIdeal = 3.14159265358979 / 3.0, kQuadIdeal = 3.14159265358979 / 2.0;
+        d->elements.resize( s.elementCount() );
+        for ( size_t e = 0; e < s.elementCount(); ++e )
+        {
+            const bool tri = e < s.triCount();
+            const double q = tri ? minAngle( s, &s.tris[e * 3], 3 ) / kTriIdeal
+                                 : minAngle( s, &s.quads[(e - s.triCount()) * 4], 4 ) / kQuadIdeal;
+            ElementAttrib& a = d->elements[e];
+            a.scalar = float( std::min( q, 1.0 ) );
+            if ( a.scalar < kPoorQuality ) a.flags |= uint16_t( ElementFlag::Poor );
+        }
+        const auto& primOfGpu = d->chunks.primOfGpu;
+        d->elementOfTri.resize( primOfGpu.size() );
+        for ( size_t g = 0; g < primOfGpu.size(); ++g )
+            d->elementOfTri[g] = s.elementOfPrimitive( primOfGpu[g] );
+    }
+
+    {
+        Trace::Scope traceIndex( "SpatialIndex::build" );
+        d->index.build( snap );
+    }
+    d->snapshot = std::move( snap );
+    return d;
+}
@@ -0,0 +1,47 @@
+// DisplayData.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "ElementAttribs.h"
+#include "LabelRenderer.h"
+#include "VertexFormat.h"
+#include "../mesh/MeshChunks.h"
+#include "../mesh/MeshSnapshot.h"
+#include "../mesh/SpatialIndex.h"
+
+struct DisplayOptions
+{
+	bool quantized = false;     // chunk-local 16-bit vertices (chunks.quantized) instead of positions
+	bool reorder = false;       // Morton vertex order and cache-friendly triangle order
+	bool operator==( const DisplayOptions& ) const = default;
+};
+
+// Everything the canvas uploads or queries for one snapshot, built on the CPU
+// only (no GL calls), so a worker can prepare it while the old mesh is drawn.
+struct DisplayData
+{
+	std::shared_ptr<const MeshSnapshot> snapshot;
+	DisplayOptions options;                 // the layout it was prepared with
+	std::vector<float> positions;           // xyz per GPU vertex; empty when quantized
+	MeshChunks chunks;                      // GPU triangle/edge order and culling boxes
+	std::vector<LabelInstance> labels;      // node, element, edge labels back to back
+	LabelGrid labelGrids[int( LabelKind::Count )];     // each kind sorted by its grid
+	std::vector<ElementAttrib> elements;    // per snapshot element
+	std::vector<uint32_t> elementOfTri;     // exact GPU triangle -> element
+	SpatialIndex index;
+
+	static std::shared_ptr<DisplayData> prepare( std::shared_ptr<const MeshSnapshot> snap, DisplayOptions options = {} );
+
+	VertexFormat format() const { return chunks.localized ? VertexFormat::Unorm16x2 : VertexFormat::Float3; }
+	const void* vertexData() const
+	{
+		return chunks.localized ? static_cast<const void*>( chunks.quantized.data() ) : positions.data();
+	}
+	size_t vertexBytes() const
+	{
+		return chunks.localized ? chunks.quantized.size() * sizeof( uint16_t ) : positions.size() * sizeof( float );
+	}
+};
@@ -0,0 +1,25 @@
+// ElementAttribs.h
+#pragma once
+#include <cstdint>
+
+// Per-element display state, one record per snapshot element in an SSBO.
+// The fill shader reaches it from gl_PrimitiveID through the chunk's first
+// triangle and an exact-triangle -> element table, so highlighting or
+// recoloring an element rewrites its 8 bytes and never touches the indices.
+enum class ElementFlag : uint16_t
+{
+	Picked = 1u << 0,
+	Poor = 1u << 1,         // quality below kPoorQuality
+};
+
+struct ElementAttrib
+{
+	uint16_t flags = 0;     // ElementFlag bits
+	uint8_t palette = 0;    // Material the element is filled with; 0 = Fill
+	uint8_t pad = 0;
+	float scalar = 1.0f;    // quality: min angle over the ideal (60 or 90 degrees)
+};
+static_assert( sizeof( ElementAttrib ) == 8, "matches the std430 ElementAttrib in the fill shader" );
+
+// elements under this quality get ElementFlag::Poor
+constexpr float kPoorQuality = 0.5f;
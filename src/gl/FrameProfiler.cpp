@@ -0,0 +1,151 @@
+// FrameProfiler.cpp
+#include "FrameProfiler.h"
+
+#include <algorithm>
+#include <cstdio>
+
+void FrameProfiler::destroy()
+{
+    for ( auto& s : slots_ )
+    {
+        if ( !s.pool.empty() ) glDeleteQueries( GLsizei( s.pool.size() ), s.pool.data() );
+        s = {};
+    }
+    current_ = nullptr;
+}
+
+void FrameProfiler::setEnabled( bool b )
+{
+    if ( b == enabled_ ) return;
+    enabled_ = b;
+    // results in flight belong to the old session
+    for ( auto& s : slots_ ) { s.pending = false; s.records.clear(); }
+    current_ = nullptr;
+}
+
+int FrameProfiler::passIndex( const char* pass )
+{
+    for ( size_t i = 0; i < passes_.size(); ++i )
+        if ( passes_[i] == pass ) return int( i );
+    passes_.push_back( pass );
+    return int( passes_.size() - 1 );
+}
+
+void FrameProfiler::beginFrame()
+{
+    if ( !enabled_ ) return;
+    Slot& s = slots_[frame_ % kLatency];
+    if ( s.pending ) resolve( s );
+    s.records.clear();
+    s.pending = false;
+    s.frame = frame_++;
+    current_ = &s;
+}
+
+void FrameProfiler::endFrame()
+{
+    if ( !current_ ) return;
+    current_->pending = !current_->records.empty();
+    current_ = nullptr;
+}
+
+int FrameProfiler::begin( const char* pass )
+{
+    if ( !current_ ) return -1;
+    Slot& s = *current_;
+    const size_t need = (s.records.size() + 1) * 2;
+    if ( s.pool.size() < need )
+    {
+        const size_t old = s.pool.size();
+        s.pool.resize( std::max( need, old * 2 ) );
+        glCreateQueries( GL_TIMESTAMP, GLsizei( s.pool.size() - old ), s.pool.data() + old );
+    }
+    Record r{ passIndex( pass ), s.pool[need - 2], s.pool[need - 1], clock::now(), {} };
+    glQueryCounter( r.q0, GL_TIMESTAMP );
+    s.records.push_back( r );
+    return int( s.records.size() - 1 );
+}
+
+void FrameProfiler::end( int handle )
+{
+    if ( !current_ || handle < 0 || size_t( handle ) >= current_->records.size() ) return;
+    Record& r = current_->records[handle];
+    glQueryCounter( r.q1, GL_TIMESTAMP );
+    r.t1 = clock::now();
+}
+
+void FrameProfiler::resolve( Slot& s )
+{
+    // records are in begin() order, not issue order (the frame scope opens
+    // first and closes last), so every end query must have landed; reading
+    // one that has not would block. If any is missing, drop the frame
+    for ( const Record& r : s.records )
+    {
+        GLint available = 0;
+        glGetQueryObjectiv( r.q1, GL_QUERY_RESULT_AVAILABLE, &available );
+        if ( !available ) return;
+    }
+
+    Row row{ s.frame, std::vector<float>( passes_.size(), -1.0f ), std::vector<float>( passes_.size(), -1.0f ) };
+    for ( const Record& r : s.records )
+    {
+        GLuint64 a = 0, b = 0;
+        glGetQueryObjectui64v( r.q0, GL_QUERY_RESULT, &a );
+        glGetQueryObjectui64v( r.q1, GL_QUERY_RESULT, &b );
+        const float gpu = float( double( b - a ) * 1e-6 );
+        const float cpu = float( std::chrono::duration<double, std::milli>( r.t1 - r.t0 ).count() );
+        // a pass run twice in a frame adds up
+        row.gpuMs[r.pass] = std::max( row.gpuMs[r.pass], 0.0f ) + gpu;
+        row.cpuMs[r.pass] = std::max( row.cpuMs[r.pass], 0.0f ) + cpu;
+    }
+    rows_.push_back( std::move( row ) );
+    if ( rows_.size() > kHistory ) rows_.pop_front();
+}
+
+std::string FrameProfiler::hudText() const
+{
+    std::string out = "pass            cpu avg/max      gpu avg/max (ms)\n";
+    const size_t n = std::min( rows_.size(), kRolling );
+    for ( size_t p = 0; p < passes_.size(); ++p )
+    {
+        double cpu = 0, gpu = 0, cpuMax = 0, gpuMax = 0;
+        size_t runs = 0;
+        for ( size_t i = rows_.size() - n; i < rows_.size(); ++i )
+        {
+            const Row& r = rows_[i];
+            if ( p >= r.cpuMs.size() || r.cpuMs[p] < 0 ) continue;
+            cpu += r.cpuMs[p]; gpu += r.gpuMs[p];
+            cpuMax = std::max<double>( cpuMax, r.cpuMs[p] );
+            gpuMax = std::max<double>( gpuMax, r.gpuMs[p] );
+            ++runs;
+        }
+        if ( !runs ) continue;
+        char line[128];
+        std::snprintf( line, sizeof( line ), "%-14s %6.2f /%6.2f   %6.2f /%6.2f\n",
+                       passes_[p].c_str(), cpu / runs, cpuMax, gpu / runs, gpuMax );
+        out += line;
+    }
+    return out;
+}
+
+bool FrameProfiler::exportCsv( const std::string& path ) const
+{
+    FILE* f = std::fopen( path.c_str(), "w" );
+    if ( !f ) return false;
+    std::fprintf( f, "frame" );
+    for ( const auto& p : passes_ ) std::fprintf( f, ",%s_cpu_ms,%s_gpu_ms", p.c_str(), p.c_str() );
+    std::fprintf( f, "\n" );
+    for ( const Row& r : rows_ )
+    {
+        std::fprintf( f, "%llu", (unsigned long long)r.frame );
+        for ( size_t p = 0; p < passes_.size(); ++p )
+        {
+            if ( p < r.cpuMs.size() && r.cpuMs[p] >= 0 )
+                std::fprintf( f, ",%.4f,%.4f", r.cpuMs[p], r.gpuMs[p] );
+            else
+                std::fprintf( f, ",," );
+        }
+        std::fprintf( f, "\n" );
+    }
+    return std::fclose( f ) == 0;
+}
@@ -0,0 +1,83 @@
+// FrameProfiler.h
+#pragma once
+#include <glad/glad.h>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+// Per-pass frame timing. Every pass is bracketed by two GL timestamp queries
+// (so passes may nest, which GL_TIME_ELAPSED does not allow) and a CPU clock.
+// Queries go into a ring of kLatency frames and are read back kLatency frames
+// later, only if available, so the GPU is never waited on; a late frame is
+// simply dropped from the statistics.
+class FrameProfiler
+{
+public:
+	static constexpr int kLatency = 4;          // frames in flight before a readback
+	static constexpr size_t kRolling = 120;     // frames in the HUD averages
+	static constexpr size_t kHistory = 36000;   // frames kept for CSV export
+
+	~FrameProfiler() { destroy(); }
+	void destroy();
+
+	void setEnabled( bool b );
+	bool enabled() const { return enabled_; }
+
+	void beginFrame();
+	void endFrame();
+
+	// returns a handle for end(); no-op (-1) when disabled
+	int begin( const char* pass );
+	void end( int handle );
+
+	class Scope
+	{
+	public:
+		Scope( FrameProfiler& p, const char* pass ) : p_( p ), h_( p.begin( pass ) ) {}
+		~Scope() { p_.end( h_ ); }
+		Scope( const Scope& ) = delete;
+		Scope& operator=( const Scope& ) = delete;
+	private:
+		FrameProfiler& p_;
+		int h_;
+	};
+
+	// rolling averages/maxima, one line per pass, in first-use order
+	std::string hudText() const;
+	// one row per resolved frame: frame, then cpu_ms/gpu_ms per pass
+	bool exportCsv( const std::string& path ) const;
+
+private:
+	using clock = std::chrono::steady_clock;
+	struct Record
+	{
+		int pass;
+		GLuint q0, q1;
+		clock::time_point t0, t1;
+	};
+	struct Slot
+	{
+		uint64_t frame = 0;
+		std::vector<Record> records;
+		std::vector<GLuint> pool;    // timestamp queries, two per record
+		bool pending = false;
+	};
+	struct Row
+	{
+		uint64_t frame;
+		std::vector<float> cpuMs, gpuMs;  // per pass; negative = pass not run
+	};
+
+	int passIndex( const char* pass );
+	void resolve( Slot& s );
+
+	bool enabled_ = false;
+	uint64_t frame_ = 0;
+	std::array<Slot, kLatency> slots_;
+	Slot* current_ = nullptr;
+	std::vector<std::string> passes_;
+	std::deque<Row> rows_;
+};
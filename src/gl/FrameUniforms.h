@@ -0,0 +1,76 @@
+// FrameUniforms.h
+#pragma once
+#include <glad/glad.h>
+#include <cstdint>
+
+#include "Math.h"
+
+// Colors a draw can select with its uMaterial uniform
+enum class Material : GLuint
+{
+    Fill = 0,
+    Hover,
+    Edge,
+    NodeLabel,
+    ElementLabel,
+    EdgeLabel,
+    Text,
+    Picked,
+    Poor,
+    Count
+};
+
+// Camera and material state shared by every program: one std140 block at
+// uniform binding 0, uploaded once per frame. Matrices use the same layout
+// glUniformMatrix4fv( ..., GL_FALSE, ... ) expected.
+//
+// Quantized meshes (MeshChunks::localize) are placed relative to the eye:
+// the shader subtracts eyeCell from each vertex's lattice point in integers,
+// and latticeProj, built on the CPU in double, takes lattice steps from the
+// eye cell to clip space. Float never sees an absolute coordinate.
+struct FrameUniforms
+{
+    Mat4 view, proj;
+    Mat4 pixelProj;             // window pixels (origin top-left) -> clip
+    Mat4 latticeProj;           // lattice steps from eyeCell -> clip
+    float viewport[4];          // width, height, pixels per world unit, 0
+    int32_t eyeCell[4];         // lattice point at the eye; z: 1 when the mesh VBO is quantized
+    float colors[int( Material::Count )][4];
+};
+static_assert( sizeof( FrameUniforms ) == 4 * 64 + 2 * 16 + 9 * 16, "std140 layout of the Frame block" );
+static_assert( int( Material::Count ) == 9, "keep uColors[] in FRAME_UNIFORMS_GLSL in step" );
+
+// GLSL side; paste between #version and the rest of a shader
+#define FRAME_UNIFORMS_GLSL \
+    "layout(std140, binding=0) uniform Frame {\n" \
+    "  mat4 uView; mat4 uProj; mat4 uPixelProj; mat4 uLatticeProj;\n" \
+    "  vec4 uViewport;\n" \
+    "  ivec4 uEyeCell;\n" \
+    "  vec4 uColors[9];\n" \
+    "};\n"
+
+class FrameUniformBuffer
+{
+public:
+    ~FrameUniformBuffer() { destroy(); }
+    void destroy()
+    {
+        if ( buf_ ) glDeleteBuffers( 1, &buf_ );
+        buf_ = 0;
+    }
+
+    // the driver orders this against draws still reading last frame's values
+    void update( const FrameUniforms& u )
+    {
+        if ( !buf_ )
+        {
+            glCreateBuffers( 1, &buf_ );
+            glNamedBufferStorage( buf_, sizeof( FrameUniforms ), nullptr, GL_DYNAMIC_STORAGE_BIT );
+        }
+        glNamedBufferSubData( buf_, 0, sizeof( FrameUniforms ), &u );
+        glBindBufferBase( GL_UNIFORM_BUFFER, 0, buf_ );
+    }
+
+private:
+    GLuint buf_ = 0;
+};
@@ -3,50 +3,116 @@
 #include <cstdint>
 #include <vector>
 
+#include "PersistentBuffer.h"
+#include "VertexFormat.h"
+#include "../mesh/Trace.h"
+
 class GpuMesh
 {
 public:
     ~GpuMesh() { destroy(); }
     void destroy()
     {
-        if ( ebo_ ) glDeleteBuffers( 1, &ebo_ );
-        if ( vbo_ ) glDeleteBuffers( 1, &vbo_ );
+        vbo_.destroy();
+        ebo_.destroy();
         if ( vao_ ) glDeleteVertexArrays( 1, &vao_ );
-        vao_ = vbo_ = ebo_ = 0; count_ = 0;
+        vao_ = 0; count_ = 0;
     }
+    // Incremental: only the ranges that changed since the last upload are
+    // written into the persistently mapped buffers
     void upload( const std::vector<float>& pos, const std::vector<uint32_t>& idx )
     {
-        destroy();
-        glCreateVertexArrays( 1, &vao_ );
-        glCreateBuffers( 1, &vbo_ );
-        glCreateBuffers( 1, &ebo_ );
+        upload( pos.data(), pos.size() * sizeof( float ), idx );
+    }
+    void upload( const void* vtx, size_t vtxBytes, const std::vector<uint32_t>& idx )
+    {
+        Trace::Scope trace( "GpuMesh::upload" );
+        createVao();
+        if ( vbo_.update( vtx, vtxBytes ) )
+            glVertexArrayVertexBuffer( vao_, 0, vbo_.id(), 0, vertexStride( format_ ) );
+        if ( ebo_.update( idx.data(), idx.size() * sizeof( uint32_t ) ) )
+            glVertexArrayElementBuffer( vao_, ebo_.id() );
 
-        GLbitfield flags = GL_DYNAMIC_STORAGE_BIT | GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
-        glNamedBufferStorage( vbo_, pos.size() * sizeof( float ), pos.data(), flags );
-        glNamedBufferStorage( ebo_, idx.size() * sizeof( uint32_t ), idx.data(), flags );
+        count_ = (GLsizei)idx.size();
+    }
 
-        glVertexArrayVertexBuffer( vao_, 0, vbo_, 0, sizeof( float ) * 3 );
-        glEnableVertexArrayAttrib( vao_, 0 );
-        glVertexArrayAttribFormat( vao_, 0, 3, GL_FLOAT, GL_FALSE, 0 );
-        glVertexArrayAttribBinding( vao_, 0, 0 );
-        glVertexArrayElementBuffer( vao_, ebo_ );
+    // layout of the next upload()/commit(); the VBO contents must match it
+    void setFormat( VertexFormat f )
+    {
+        if ( f == format_ ) return;
+        format_ = f;
+        if ( !vao_ ) return;
+        setVertexFormat( vao_, format_ );
+        glVertexArrayVertexBuffer( vao_, 0, vbo_.id(), 0, vertexStride( format_ ) );
+    }
+    VertexFormat format() const { return format_; }
 
-        count_ = (GLsizei)idx.size();
+    // Sliced replacement (see PersistentBuffer::stage): the current contents
+    // stay drawable until commit(). pos/idx must not change in between.
+    bool stage( const void* vtx, size_t vtxBytes, const std::vector<uint32_t>& idx, size_t& budget )
+    {
+        Trace::Scope trace( "GpuMesh::stage" );
+        return vbo_.stage( vtx, vtxBytes, budget )
+            && ebo_.stage( idx.data(), idx.size() * sizeof( uint32_t ), budget );
     }
+    void commit()
+    {
+        createVao();
+        vbo_.commit();
+        ebo_.commit();
+        glVertexArrayVertexBuffer( vao_, 0, vbo_.id(), 0, vertexStride( format_ ) );
+        glVertexArrayElementBuffer( vao_, ebo_.id() );
+        count_ = GLsizei( ebo_.size() / sizeof( uint32_t ) );
+    }
+    void cancelStage() { vbo_.cancelStage(); ebo_.cancelStage(); }
 
 	GLuint Vao() { return vao_; }
-	GLuint Vbo() { return vbo_; }
+	GLuint Vbo() { return vbo_.id(); }
 	GLsizei IndexCount() const { return count_; }
 
+    // bytes written by the last upload() vs. bytes it describes
+    size_t LastUploadBytes() const { return vbo_.lastUploadBytes() + ebo_.lastUploadBytes(); }
+    size_t SizeBytes() const { return vbo_.size() + ebo_.size(); }
+    size_t VertexBytes() const { return vbo_.size(); }
+
     void draw() const
     {
         glBindVertexArray( vao_ );
         glDrawElements( GL_TRIANGLES, count_, GL_UNSIGNED_INT, (void*)0 );
     }
 
-    bool valid() const { return vao_ != 0; }
+    // one draw per command, e.g. the chunks that survived culling
+    void drawIndirect( GLuint indirectBuf, const void* offset, GLsizei drawCount ) const
+    {
+        if ( drawCount <= 0 ) return;
+        glBindVertexArray( vao_ );
+        glBindBuffer( GL_DRAW_INDIRECT_BUFFER, indirectBuf );
+        glMultiDrawElementsIndirect( GL_TRIANGLES, GL_UNSIGNED_INT, offset, drawCount, 0 );
+    }
+
+    // draw a sub-range of the index buffer (e.g. one highlighted triangle);
+    // baseVertex/baseInstance as in the chunk's indirect command
+    void drawRange( GLsizei firstIndex, GLsizei count, GLint baseVertex = 0, GLuint baseInstance = 0 ) const
+    {
+        if ( firstIndex < 0 || firstIndex + count > count_ ) return;
+        glBindVertexArray( vao_ );
+        glDrawElementsInstancedBaseVertexBaseInstance( GL_TRIANGLES, count, GL_UNSIGNED_INT,
+                                                       (void*)(size_t( firstIndex ) * sizeof( uint32_t )), 1,
+                                                       baseVertex, baseInstance );
+    }
+
+    bool valid() const { return vao_ != 0 && count_ > 0; }
 
 private:
-    GLuint vao_ = 0, vbo_ = 0, ebo_ = 0;
+    void createVao()
+    {
+        if ( vao_ ) return;
+        glCreateVertexArrays( 1, &vao_ );
+        setVertexFormat( vao_, format_ );
+    }
+
+    GLuint vao_ = 0;
+    VertexFormat format_ = VertexFormat::Float3;
+    PersistentBuffer vbo_, ebo_;
     GLsizei count_ = 0;
 };
@@ -0,0 +1,93 @@
+#pragma once
+#include <glad/glad.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+// Draw commands for glMultiDraw*Indirect, written by the CPU every frame into
+// a persistently mapped buffer. Each begin() takes the next region (a frame
+// may take two: a layer band and a pick), and a fence per region keeps us
+// from overwriting commands the GPU has not consumed yet.
+class IndirectRing
+{
+public:
+    struct Command
+    {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint  baseVertex;
+        GLuint baseInstance;
+    };
+    static constexpr int kRegions = 6;     // triple-buffered at two per frame
+
+    ~IndirectRing() { destroy(); }
+    void destroy()
+    {
+        waitAll();
+        if ( buf_ )
+        {
+            glUnmapNamedBuffer( buf_ );
+            glDeleteBuffers( 1, &buf_ );
+        }
+        buf_ = 0; ptr_ = nullptr; perRegion_ = 0;
+        open_ = false;
+    }
+
+    // Next region, with room for n commands. The draws reading the current
+    // one have all been issued by now, so it is fenced first
+    Command* begin( size_t n )
+    {
+        fence();
+        region_ = (region_ + 1) % kRegions;
+        if ( n > perRegion_ )
+        {
+            const size_t per = std::max<size_t>( { n, perRegion_ * 2, 64 } );
+            destroy();
+            perRegion_ = per;
+            const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glCreateBuffers( 1, &buf_ );
+            glNamedBufferStorage( buf_, GLsizeiptr( kRegions * perRegion_ * sizeof( Command ) ), nullptr, flags );
+            ptr_ = static_cast<Command*>(glMapNamedBufferRange( buf_, 0, GLsizeiptr( kRegions * perRegion_ * sizeof( Command ) ), flags ));
+        }
+        else
+            wait( region_ );
+        open_ = true;
+        return ptr_ + region_ * perRegion_;
+    }
+
+    // Fence the current region once every draw reading it has been issued;
+    // at the end of the frame, for the last begin()
+    void end() { fence(); }
+
+    GLuint id() const { return buf_; }
+    // command i of the current region, as the 'indirect' argument
+    const void* offset( size_t i ) const
+    {
+        return reinterpret_cast<const void*>((region_ * perRegion_ + i) * sizeof( Command ));
+    }
+
+private:
+    void fence()
+    {
+        if ( !buf_ || !open_ ) return;
+        if ( fences_[region_] ) glDeleteSync( fences_[region_] );
+        fences_[region_] = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+        open_ = false;
+    }
+    void wait( int r )
+    {
+        if ( !fences_[r] ) return;
+        glClientWaitSync( fences_[r], GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64( 1000000000 ) );
+        glDeleteSync( fences_[r] );
+        fences_[r] = nullptr;
+    }
+    void waitAll() { for ( int r = 0; r < kRegions; ++r ) wait( r ); }
+
+    GLuint buf_ = 0;
+    Command* ptr_ = nullptr;
+    size_t perRegion_ = 0;
+    int region_ = 0;
+    bool open_ = false;         // region_ handed out and not fenced yet
+    GLsync fences_[kRegions] = {};
+};
@@ -0,0 +1,325 @@
+// LabelRenderer.cpp
+#include "LabelRenderer.h"
+#include "Math.h"
+#include "FrameUniforms.h"
+
+#include "../third_party/stb/stb_easy_font.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+static const char* kLabelVS = R"(#version 460 core
+)" FRAME_UNIFORMS_GLSL R"(
+layout(location=0) in vec2 aAnchor;     // per instance
+layout(location=1) in uint aId;         // per instance
+uniform vec2 uCellPx;                   // atlas cell size in screen pixels
+uniform float uAdvancePx;
+uniform vec2 uOffsetPx;
+uniform bool uCenter;
+uniform float uAtlasCells;
+out vec2 vUV;
+
+const vec2 kCorner[6] = vec2[]( vec2(0,0), vec2(1,0), vec2(1,1), vec2(0,0), vec2(1,1), vec2(0,1) );
+
+void main(){
+  int slot = gl_VertexID / 6;
+  vec2 c = kCorner[gl_VertexID % 6];
+
+  uint digits = 1u;
+  for ( uint t = aId; t >= 10u; t /= 10u ) ++digits;
+
+  vec4 clip = uProj * uView * vec4( aAnchor, 0.0, 1.0 );
+  // past the last digit, or anchor far off screen: emit a degenerate vertex
+  if ( uint(slot) >= digits || any( greaterThan( abs( clip.xy ), vec2( 1.5 ) ) ) ) {
+    gl_Position = vec4( 2.0, 2.0, 2.0, 1.0 );
+    vUV = vec2( 0 );
+    return;
+  }
+
+  uint p = 1u;
+  for ( uint i = uint(slot) + 1u; i < digits; ++i ) p *= 10u;
+  uint d = (aId / p) % 10u;
+
+  vec2 origin = uOffsetPx;
+  if ( uCenter ) origin -= vec2( float(digits) * uAdvancePx, uCellPx.y ) * 0.5;
+  vec2 px = origin + vec2( float(slot) * uAdvancePx, 0.0 ) + c * uCellPx;
+
+  gl_Position = vec4( clip.xy + px * 2.0 / uViewport.xy, 0.0, 1.0 );
+  vUV = vec2( (float(d) + c.x) / uAtlasCells, 1.0 - c.y );
+}
+)";
+
+static const char* kLabelFS = R"(#version 460 core
+)" FRAME_UNIFORMS_GLSL R"(
+layout(binding=0) uniform sampler2D uAtlas;
+uniform uint uMaterial;
+in vec2 vUV;
+out vec4 FragColor;
+void main(){
+  float d = texture( uAtlas, vUV ).r;   // 0.5 = glyph edge
+  float w = max( fwidth( d ), 1e-4 );
+  float a = smoothstep( 0.5 - w, 0.5 + w, d );
+  if ( a <= 0.0 ) discard;
+  vec4 color = uColors[uMaterial];
+  FragColor = vec4( color.rgb, color.a * a );
+}
+)";
+
+void LabelRenderer::destroy()
+{
+    if ( atlas_ ) glDeleteTextures( 1, &atlas_ ), atlas_ = 0;
+    instances_.destroy();
+    for ( auto& c : commands_ ) c.destroy();
+    if ( vao_ ) glDeleteVertexArrays( 1, &vao_ ), vao_ = 0;
+    for ( auto& r : ranges_ ) r = {};
+}
+
+void LabelRenderer::create()
+{
+    destroy();
+    shader_.build( kLabelVS, kLabelFS );
+    buildAtlas();
+
+    // constant screen size; the SDF keeps edges crisp at any magnification
+    const float pxPerTexel = kPxPerFontUnit / texelsPerUnit_;
+    shader_.setVec2( "uCellPx", cellW_ * pxPerTexel, cellH_ * pxPerTexel );
+    shader_.setFloat( "uAdvancePx", advance_ * pxPerTexel );
+    shader_.setFloat( "uAtlasCells", 10.f );
+
+    glCreateVertexArrays( 1, &vao_ );
+    glVertexArrayBindingDivisor( vao_, 0, 1 );
+    glEnableVertexArrayAttrib( vao_, 0 );
+    glVertexArrayAttribFormat( vao_, 0, 2, GL_FLOAT, GL_FALSE, offsetof( LabelInstance, x ) );
+    glVertexArrayAttribBinding( vao_, 0, 0 );
+    glEnableVertexArrayAttrib( vao_, 1 );
+    glVertexArrayAttribIFormat( vao_, 1, 1, GL_UNSIGNED_INT, offsetof( LabelInstance, id ) );
+    glVertexArrayAttribBinding( vao_, 1, 0 );
+}
+
+void LabelRenderer::buildAtlas()
+{
+    // stb_easy_font glyphs are made of axis-aligned quads in font units;
+    // rasterize them at kScale texels per unit and turn that into an SDF
+    constexpr int kScale = 8;
+    constexpr int kPad = 4;                 // texels, also the SDF spread
+
+    static unsigned char scratch[4096];
+    std::vector<float> quads[10];           // x0,y0,x1,y1 per quad, font units
+    float maxW = 0.f, maxH = 0.f, adv = 0.f;
+    for ( int d = 0; d < 10; ++d )
+    {
+        char text[2] = { char( '0' + d ), '\0' };
+        const int n = stb_easy_font_print( 0.f, 0.f, text, nullptr, scratch, (int)sizeof( scratch ) );
+        for ( int q = 0; q < n; ++q )
+        {
+            const float* v0 = reinterpret_cast<const float*>(scratch + q * 64);
+            const float* v2 = reinterpret_cast<const float*>(scratch + q * 64 + 32);
+            quads[d].insert( quads[d].end(), { v0[0], v0[1], v2[0], v2[1] } );
+            maxW = std::max( maxW, v2[0] );
+            maxH = std::max( maxH, v2[1] );
+        }
+        adv = std::max( adv, float( stb_easy_font_width( text ) ) );
+    }
+
+    const int cw = int( std::ceil( maxW ) ) * kScale + 2 * kPad;
+    const int ch = int( std::ceil( maxH ) ) * kScale + 2 * kPad;
+    const int aw = cw * 10;
+    std::vector<uint8_t> inside( size_t( aw ) * ch, 0 );
+    for ( int d = 0; d < 10; ++d )
+    {
+        for ( size_t q = 0; q < quads[d].size(); q += 4 )
+        {
+            const int x0 = d * cw + kPad + int( quads[d][q + 0] * kScale );
+            const int y0 = kPad + int( quads[d][q + 1] * kScale );
+            const int x1 = d * cw + kPad + int( quads[d][q + 2] * kScale );
+            const int y1 = kPad + int( quads[d][q + 3] * kScale );
+            for ( int y = y0; y < y1; ++y )
+                for ( int x = x0; x < x1; ++x )
+                    inside[size_t( y ) * aw + x] = 1;
+        }
+    }
+
+    // brute-force SDF, search limited to the padding radius
+    std::vector<uint8_t> sdf( inside.size() );
+    for ( int y = 0; y < ch; ++y )
+        for ( int x = 0; x < aw; ++x )
+        {
+            const uint8_t self = inside[size_t( y ) * aw + x];
+            float best = float( kPad );
+            for ( int dy = -kPad; dy <= kPad; ++dy )
+                for ( int dx = -kPad; dx <= kPad; ++dx )
+                {
+                    const int sx = x + dx, sy = y + dy;
+                    const uint8_t other = (sx < 0 || sy < 0 || sx >= aw || sy >= ch) ? 0 : inside[size_t( sy ) * aw + sx];
+                    if ( other != self )
+                        best = std::min( best, std::sqrt( float( dx * dx + dy * dy ) ) - 0.5f );
+                }
+            const float signedDist = self ? best : -best;
+            sdf[size_t( y ) * aw + x] = uint8_t( std::clamp( 0.5f + 0.5f * signedDist / kPad, 0.f, 1.f ) * 255.f + 0.5f );
+        }
+
+    glCreateTextures( GL_TEXTURE_2D, 1, &atlas_ );
+    glTextureStorage2D( atlas_, 1, GL_R8, aw, ch );
+    glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+    glTextureSubImage2D( atlas_, 0, 0, 0, aw, ch, GL_RED, GL_UNSIGNED_BYTE, sdf.data() );
+    glPixelStorei( GL_UNPACK_ALIGNMENT, 4 );
+    glTextureParameteri( atlas_, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+    glTextureParameteri( atlas_, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+    glTextureParameteri( atlas_, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+    glTextureParameteri( atlas_, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+
+    cellW_ = float( cw );
+    cellH_ = float( ch );
+    texelsPerUnit_ = float( kScale );
+    advance_ = adv * kScale;
+}
+
+namespace
+{
+    int digitsOf( uint32_t id )
+    {
+        int n = 1;
+        for ( ; id >= 10u; id /= 10u ) ++n;
+        return n;
+    }
+}
+
+LabelGrid LabelGrid::build( LabelInstance* labels, size_t count, float minX, float minY, float maxX, float maxY )
+{
+    LabelGrid g;
+    const float w = std::max( maxX - minX, 1e-6f ), h = std::max( maxY - minY, 1e-6f );
+    const double cells = std::clamp<double>( double( count ) / kPerCell, 1.0, double( 1 << 20 ) );
+    g.minX = minX;
+    g.minY = minY;
+    g.cell = float( std::sqrt( double( w ) * h / cells ) );
+    g.cellsX = std::max( 1, int( std::ceil( w / g.cell ) ) );
+    g.cellsY = std::max( 1, int( std::ceil( h / g.cell ) ) );
+
+    int lo = INT_MAX, hi = 1;
+    for ( size_t i = 0; i < count; ++i )
+    {
+        const int d = digitsOf( labels[i].id );
+        lo = std::min( lo, d );
+        hi = std::max( hi, d );
+    }
+    g.minDigits = count ? lo : 1;
+    g.digitCounts = count ? hi - lo + 1 : 0;
+
+    // counting sort on (digit bucket, row, column); stable within a bucket
+    const size_t nc = g.cells();
+    auto bucketOf = [&]( const LabelInstance& l )
+        {
+            const int cx = std::clamp( int( (l.x - g.minX) / g.cell ), 0, g.cellsX - 1 );
+            const int cy = std::clamp( int( (l.y - g.minY) / g.cell ), 0, g.cellsY - 1 );
+            return size_t( digitsOf( l.id ) - g.minDigits ) * nc + size_t( cy ) * g.cellsX + cx;
+        };
+    g.start.assign( size_t( g.digitCounts ) * nc + 1, 0 );
+    for ( size_t i = 0; i < count; ++i ) ++g.start[bucketOf( labels[i] ) + 1];
+    for ( size_t b = 1; b < g.start.size(); ++b ) g.start[b] += g.start[b - 1];
+    std::vector<uint32_t> at( g.start.begin(), g.start.end() - 1 );
+    std::vector<LabelInstance> sorted( count );
+    for ( size_t i = 0; i < count; ++i ) sorted[at[bucketOf( labels[i] )]++] = labels[i];
+    std::copy( sorted.begin(), sorted.end(), labels );
+    return g;
+}
+
+void LabelRenderer::upload( const std::vector<LabelInstance>& all, const LabelGrid grids[] )
+{
+    if ( !vao_ ) return;
+    setRanges( grids );
+    // moved nodes only touch their own instances
+    if ( instances_.update( all.data(), all.size() * sizeof( LabelInstance ) ) )
+        glVertexArrayVertexBuffer( vao_, 0, instances_.id(), 0, sizeof( LabelInstance ) );
+}
+
+bool LabelRenderer::stage( const std::vector<LabelInstance>& all, size_t& budget )
+{
+    return !vao_ || instances_.stage( all.data(), all.size() * sizeof( LabelInstance ), budget );
+}
+
+void LabelRenderer::commit( const LabelGrid grids[] )
+{
+    if ( !vao_ ) return;
+    instances_.commit();
+    setRanges( grids );
+    glVertexArrayVertexBuffer( vao_, 0, instances_.id(), 0, sizeof( LabelInstance ) );
+}
+
+void LabelRenderer::setRanges( const LabelGrid grids[] )
+{
+    size_t first = 0;
+    for ( int k = 0; k < int( LabelKind::Count ); ++k )
+    {
+        grids_[k] = grids[k];
+        ranges_[k] = { first, grids[k].count() };
+        first += ranges_[k].count;
+    }
+}
+
+void LabelRenderer::draw( LabelKind kind, float left, float right, float bottom, float top, float pixelsPerUnit )
+{
+    const Range& r = ranges_[int( kind )];
+    const LabelGrid& g = grids_[int( kind )];
+    if ( !vao_ || r.count == 0 || g.count() != r.count ) return;
+
+    // the text reaches past its anchor; widen the window by the longest label
+    const float margin = (advance_ * kMaxDigits * kPxPerFontUnit / texelsPerUnit_) / std::max( pixelsPerUnit, 1e-6f );
+    const int cx0 = std::max( 0, int( std::floor( (left - margin - g.minX) / g.cell ) ) );
+    const int cx1 = std::min( g.cellsX - 1, int( std::floor( (right + margin - g.minX) / g.cell ) ) );
+    const int cy0 = std::max( 0, int( std::floor( (bottom - margin - g.minY) / g.cell ) ) );
+    const int cy1 = std::min( g.cellsY - 1, int( std::floor( (top + margin - g.minY) / g.cell ) ) );
+    if ( cx0 > cx1 || cy0 > cy1 ) return;
+
+    glEnable( GL_BLEND );
+    glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+    glDisable( GL_DEPTH_TEST );
+
+    shader_.use();
+    shader_.setUInt( "uMaterial", GLuint( Material::NodeLabel ) + GLuint( kind ) );
+    const bool center = kind != LabelKind::Node;
+    shader_.setInt( "uCenter", center ? 1 : 0 );
+    // nodes: just above-right of the point so it doesn't sit on it
+    shader_.setVec2( "uOffsetPx", center ? 0.f : 3.f, center ? 0.f : 3.f );
+    glBindTextureUnit( 0, atlas_ );
+
+    // one command per digit count and row of cells, merged where rows touch;
+    // each instance expands to exactly its own digits
+    runs_.clear();
+    const size_t nc = g.cells();
+    for ( int b = 0; b < g.digitCounts; ++b )
+    {
+        const GLsizei vertices = 6 * (g.minDigits + b);
+        uint32_t runBegin = 0, runEnd = 0;
+        for ( int cy = cy0; cy <= cy1 + 1; ++cy )
+        {
+            uint32_t first = runEnd, last = runEnd;
+            if ( cy <= cy1 )
+            {
+                const size_t row = size_t( b ) * nc + size_t( cy ) * g.cellsX;
+                first = g.start[row + cx0];
+                last = g.start[row + cx1 + 1];
+            }
+            if ( first != runEnd || cy > cy1 )
+            {
+                if ( runEnd > runBegin )
+                    runs_.push_back( { GLuint( vertices ), runEnd - runBegin, 0, GLuint( r.first + runBegin ) } );
+                runBegin = first;
+            }
+            runEnd = last;
+        }
+    }
+
+    // all of them in one call; the buffer rewrites only commands that moved
+    PersistentBuffer& commands = commands_[int( kind )];
+    if ( !runs_.empty() )
+    {
+        commands.update( runs_.data(), runs_.size() * sizeof( DrawCommand ) );
+        glBindVertexArray( vao_ );
+        glBindBuffer( GL_DRAW_INDIRECT_BUFFER, commands.id() );
+        glMultiDrawArraysIndirect( GL_TRIANGLES, nullptr, GLsizei( runs_.size() ), 0 );
+    }
+
+    glDisable( GL_BLEND );
+    glEnable( GL_DEPTH_TEST );
+}
@@ -0,0 +1,95 @@
+// LabelRenderer.h
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <glad/glad.h>
+
+#include "Shader.h"
+#include "PersistentBuffer.h"
+
+enum class LabelKind : int
+{
+	Node = 0,
+	Element,
+	Edge,
+	Count
+};
+
+// one label = world-space anchor + the number to print
+struct LabelInstance
+{
+	float x, y;
+	uint32_t id;
+};
+
+// The labels of one kind, ordered for culling: by digit count, then by cell
+// of a uniform grid, row by row. Labels of one digit count in a row of cells
+// are then contiguous, and a window is drawn as a few instance ranges.
+struct LabelGrid
+{
+	static constexpr size_t kPerCell = 64;     // labels per cell, on average
+
+	float minX = 0.f, minY = 0.f, cell = 1.f;
+	int cellsX = 0, cellsY = 0;
+	int minDigits = 1, digitCounts = 0;         // buckets for minDigits .. minDigits + digitCounts - 1
+	std::vector<uint32_t> start;                // per (digit bucket, cell), plus one sentinel
+
+	size_t count() const { return start.empty() ? 0 : start.back(); }
+	size_t cells() const { return size_t( cellsX ) * cellsY; }
+
+	// CPU only: sorts labels[0 .. count) in place and returns their grid
+	static LabelGrid build( LabelInstance* labels, size_t count, float minX, float minY, float maxX, float maxY );
+};
+
+// Instanced numeric labels. The digits 0-9 are rasterized once into a
+// signed-distance-field atlas; each label is a single (anchor, id)
+// instance and the vertex shader expands it into digit quads. Instances
+// are uploaded when the mesh changes; each frame only the grid cells in
+// view are drawn, one indirect command per digit count and row of cells and
+// one multi-draw per kind.
+class LabelRenderer
+{
+public:
+	static constexpr int kMaxDigits = 10;   // uint32 max
+	static constexpr float kPxPerFontUnit = 1.5f; // on-screen size, stb_easy_font units
+
+	~LabelRenderer() { destroy(); }
+	void destroy();
+	void create();
+
+	// all kinds back to back, each sorted by its grid (LabelGrid::build)
+	void upload( const std::vector<LabelInstance>& all, const LabelGrid grids[] );
+	// sliced variant, see PersistentBuffer::stage()
+	bool stage( const std::vector<LabelInstance>& all, size_t& budget );
+	void commit( const LabelGrid grids[] );
+	void cancelStage() { instances_.cancelStage(); }
+	// the labels of kind whose cells meet the window; camera, viewport and
+	// color come from the Frame block (FrameUniforms.h)
+	void draw( LabelKind kind, float left, float right, float bottom, float top, float pixelsPerUnit );
+
+	size_t count( LabelKind kind ) const { return ranges_[int( kind )].count; }
+	size_t lastUploadBytes() const { return instances_.lastUploadBytes(); }
+
+private:
+	void buildAtlas();
+	void setRanges( const LabelGrid grids[] );
+
+	struct Range { size_t first = 0, count = 0; };
+	Range ranges_[int( LabelKind::Count )];
+	LabelGrid grids_[int( LabelKind::Count )];
+
+	// glMultiDrawArraysIndirect layout
+	struct DrawCommand { GLuint count, instanceCount, first, baseInstance; };
+
+	Shader shader_;
+	GLuint vao_ = 0;
+	PersistentBuffer instances_;    // LabelInstance array, all kinds back to back
+	PersistentBuffer commands_[int( LabelKind::Count )];   // last draw() of each kind
+	std::vector<DrawCommand> runs_;
+	GLuint atlas_ = 0;              // R8 SDF, ten cells side by side
+
+	float cellW_ = 0.f, cellH_ = 0.f;   // atlas cell in texels
+	float texelsPerUnit_ = 1.f;         // atlas resolution per font unit
+	float advance_ = 0.f;               // digit advance in texels
+};
@@ -0,0 +1,179 @@
+// LayerCache.cpp
+#include "LayerCache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+// one triangle over the viewport; uArea is the view inside the cached
+// image, in texture coordinates (u0, v0, u1, v1)
+static const char* kCompositeVS = R"(#version 460 core
+uniform vec4 uArea;
+out vec2 vUV;
+void main(){
+  vec2 s = vec2( (gl_VertexID << 1) & 2, gl_VertexID & 2 );
+  vUV = mix( uArea.xy, uArea.zw, s );
+  gl_Position = vec4( s * 2.0 - 1.0, 0.0, 1.0 );
+}
+)";
+
+static const char* kCompositeFS = R"(#version 460 core
+layout(binding=0) uniform sampler2D uLayers;
+in vec2 vUV;
+out vec4 FragColor;
+void main(){ FragColor = texture( uLayers, vUV ); }
+)";
+
+void LayerCache::destroy()
+{
+    release( front_ );
+    release( back_ );
+    if ( vao_ ) glDeleteVertexArrays( 1, &vao_ ), vao_ = 0;
+    texW_ = texH_ = 0;
+    valid_ = false;
+    next_ = -1;
+}
+
+void LayerCache::allocate( Target& t )
+{
+    glCreateTextures( GL_TEXTURE_2D, 1, &t.tex );
+    glTextureStorage2D( t.tex, 1, GL_RGBA8, texW_, texH_ );
+    glTextureParameteri( t.tex, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+    glTextureParameteri( t.tex, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+    glTextureParameteri( t.tex, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+    glTextureParameteri( t.tex, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+    glCreateFramebuffers( 1, &t.fbo );
+    glNamedFramebufferTexture( t.fbo, GL_COLOR_ATTACHMENT0, t.tex, 0 );
+}
+
+void LayerCache::release( Target& t )
+{
+    if ( t.fbo ) glDeleteFramebuffers( 1, &t.fbo ), t.fbo = 0;
+    if ( t.tex ) glDeleteTextures( 1, &t.tex ), t.tex = 0;
+}
+
+void LayerCache::create()
+{
+    destroy();
+    shader_.build( kCompositeVS, kCompositeFS );
+    glCreateVertexArrays( 1, &vao_ );
+}
+
+bool LayerCache::covers( const Window& view, int w, int h, float zoom ) const
+{
+    if ( !valid_ || w != w_ || h != h_ ) return false;
+    const float s = zoom / zoom_;
+    if ( s > kMaxRescale || s < 1.0f / kMaxRescale ) return false;
+    return view.left >= area_.left && view.right <= area_.right
+        && view.bottom >= area_.bottom && view.top <= area_.top;
+}
+
+bool LayerCache::exact( const Window& view, int w, int h, float zoom ) const
+{
+    return complete_ && zoom == zoom_ && covers( view, w, h, zoom );
+}
+
+LayerCache::Window LayerCache::begin( const Window& view, int w, int h, float zoom, bool complete )
+{
+    const int tw = w + 2 * kMarginPx, th = h + 2 * kMarginPx;
+    if ( tw != texW_ || th != texH_ )
+    {
+        // the second target is allocated when a refresh first needs it
+        release( front_ );
+        release( back_ );
+        texW_ = tw; texH_ = th;
+        allocate( front_ );
+    }
+    next_ = -1;     // rendered in full now; a refresh in progress is moot
+
+    const float m = float( kMarginPx ) / zoom;
+    area_ = { view.left - m, view.right + m, view.bottom - m, view.top + m };
+    w_ = w; h_ = h; zoom_ = zoom;
+    complete_ = complete;
+    valid_ = true;
+
+    glBindFramebuffer( GL_FRAMEBUFFER, front_.fbo );
+    glViewport( 0, 0, texW_, texH_ );
+    glClear( GL_COLOR_BUFFER_BIT );     // the canvas clear color
+    return area_;
+}
+
+void LayerCache::end()
+{
+    glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+}
+
+bool LayerCache::refreshDue( const Window& view, int w, int h, float zoom ) const
+{
+    if ( !covers( view, w, h, zoom ) ) return false;
+    if ( next_ >= 0 ) return true;
+    const float s = zoom / zoom_;
+    const float soft = std::sqrt( kMaxRescale );
+    if ( s > soft || s < 1.0f / soft ) return true;
+    const float m = float( kAheadPx ) / zoom;
+    return view.left - m < area_.left || view.right + m > area_.right
+        || view.bottom - m < area_.bottom || view.top + m > area_.top;
+}
+
+LayerCache::Band LayerCache::beginBand( const Window& view, float zoom, bool complete )
+{
+    if ( next_ < 0 )
+    {
+        // same size as the image it replaces; begin() handled any resize
+        if ( !back_.fbo ) allocate( back_ );
+        const float m = float( kMarginPx ) / zoom;
+        nextArea_ = { view.left - m, view.right + m, view.bottom - m, view.top + m };
+        nextZoom_ = zoom;
+        nextComplete_ = complete;
+        next_ = 0;
+    }
+
+    // rows [y0, y1) of the target, bottom up like the area
+    const int y0 = next_ * bandHeight(), y1 = std::min( texH_, y0 + bandHeight() );
+    const float ah = nextArea_.top - nextArea_.bottom;
+    Band b;
+    b.area = nextArea_;
+    b.band = { nextArea_.left, nextArea_.right,
+               nextArea_.bottom + ah * float( y0 ) / float( texH_ ), nextArea_.bottom + ah * float( y1 ) / float( texH_ ) };
+    b.zoom = nextZoom_;
+    b.complete = nextComplete_;
+
+    glBindFramebuffer( GL_FRAMEBUFFER, back_.fbo );
+    glViewport( 0, 0, texW_, texH_ );
+    glEnable( GL_SCISSOR_TEST );
+    glScissor( 0, y0, texW_, y1 - y0 );
+    glClear( GL_COLOR_BUFFER_BIT );
+    return b;
+}
+
+void LayerCache::endBand()
+{
+    glDisable( GL_SCISSOR_TEST );
+    glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+    if ( ++next_ < kBands ) return;
+
+    // complete: the fresh image takes over
+    std::swap( front_, back_ );
+    area_ = nextArea_;
+    zoom_ = nextZoom_;
+    complete_ = nextComplete_;
+    next_ = -1;
+}
+
+void LayerCache::composite( const Window& view )
+{
+    if ( !valid_ ) return;
+    const float aw = area_.right - area_.left, ah = area_.top - area_.bottom;
+    const float uv[4] = {
+        (view.left - area_.left) / aw, (view.bottom - area_.bottom) / ah,
+        (view.right - area_.left) / aw, (view.top - area_.bottom) / ah };
+
+    glDisable( GL_DEPTH_TEST );
+    glDisable( GL_BLEND );
+    shader_.use();
+    shader_.setVec4( "uArea", uv );
+    glBindTextureUnit( 0, front_.tex );
+    glBindVertexArray( vao_ );
+    glDrawArrays( GL_TRIANGLES, 0, 3 );
+    glEnable( GL_DEPTH_TEST );
+}
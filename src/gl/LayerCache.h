@@ -0,0 +1,87 @@
+// LayerCache.h
+#pragma once
+#include <glad/glad.h>
+
+#include "Shader.h"
+
+// The static layers (fill, overlay, labels) rendered once into an offscreen
+// texture that covers the window plus kMarginPx on every side. While the
+// view stays inside that area a frame is a single textured triangle: pans
+// shift the lookup and zooms rescale it, whatever the size of the mesh.
+// The caller re-renders when covers() fails, and refines when the image is
+// not exact() and the camera has settled.
+//
+// Before the view gets that far, refreshDue() asks for a fresh image around
+// it: the caller renders it into a second target one horizontal band per
+// frame (beginBand() / endBand()) while the old image is still composited,
+// and it is swapped in once the last band is done.
+class LayerCache
+{
+public:
+	static constexpr int kMarginPx = 256;
+	static constexpr float kMaxRescale = 2.0f;  // zoom drift before the image is too soft
+	static constexpr int kAheadPx = kMarginPx / 2;  // margin left when the refresh starts
+	static constexpr int kBands = 4;            // frames a refresh is spread over
+
+	// world-space rectangle
+	struct Window { float left = 0, right = 0, bottom = 0, top = 0; };
+
+	// one band of a refresh: render area at zoom as usual, limited to band
+	// (world space) and to the band's rows, bandHeight() of height()
+	struct Band { Window area, band; float zoom = 1.0f; bool complete = false; };
+
+	~LayerCache() { destroy(); }
+	void destroy();
+	void create();
+	// the layers changed; the next frame re-renders
+	void invalidate() { valid_ = false; next_ = -1; }
+
+	// the image can stand in for a w x h view at zoom: same window size,
+	// zoom within kMaxRescale, and the view inside the cached area
+	bool covers( const Window& view, int w, int h, float zoom ) const;
+	// pixel for pixel: covers(), same zoom, and rendered with every layer
+	bool exact( const Window& view, int w, int h, float zoom ) const;
+
+	// Binds and clears the target for the area around view and returns that
+	// area; render into width() x height() pixels, then end()
+	Window begin( const Window& view, int w, int h, float zoom, bool complete );
+	void end();
+	int width() const { return texW_; }
+	int height() const { return texH_; }
+
+	// covers() holds, but the view is within kAheadPx of the edge of the
+	// cached area or halfway to kMaxRescale, or a refresh is under way
+	bool refreshDue( const Window& view, int w, int h, float zoom ) const;
+	// Binds the second target for the next band of the refresh, starting one
+	// around view if none is running; render it, then endBand()
+	Band beginBand( const Window& view, float zoom, bool complete );
+	void endBand();
+	bool refreshing() const { return next_ >= 0; }
+	int bandHeight() const { return (texH_ + kBands - 1) / kBands; }
+
+	// the cached image mapped onto the current viewport, which shows view
+	void composite( const Window& view );
+
+private:
+	struct Target { GLuint fbo = 0, tex = 0; };
+	void allocate( Target& t );
+	static void release( Target& t );
+
+	Shader shader_;
+	GLuint vao_ = 0;                // empty; the triangle comes from gl_VertexID
+	Target front_;                  // composited
+	Target back_;                   // refresh being rendered
+	int texW_ = 0, texH_ = 0;
+
+	bool valid_ = false;
+	bool complete_ = false;         // labels and overlay included
+	int w_ = 0, h_ = 0;             // window size it was rendered for
+	float zoom_ = 1.0f;
+	Window area_;
+
+	// the refresh: next band to render, -1 when none is running
+	int next_ = -1;
+	bool nextComplete_ = false;
+	float nextZoom_ = 1.0f;
+	Window nextArea_;
+};
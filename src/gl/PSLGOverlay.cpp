@@ -1,91 +1,70 @@
 // PSLGOverlay.cpp
 #include "PSLGOverlay.h"
-#include <cmath>
+#include "../mesh/Trace.h"
 
 void PSLGOverlay::destroy()
 {
-    if ( eboSeg_ ) glDeleteBuffers( 1, &eboSeg_ ), eboSeg_ = 0;
-    if ( eboArc_ ) glDeleteBuffers( 1, &eboArc_ ), eboArc_ = 0;
+    segBuf_.destroy();
     if ( vao_ )    glDeleteVertexArrays( 1, &vao_ ), vao_ = 0;
-    segCount_ = 0; arcIndexCount_ = 0;
-    arcStripStarts_.clear(); arcStripCounts_.clear();
+    segCount_ = 0;
 }
 
-void PSLGOverlay::create( GLuint sharedVbo )
+void PSLGOverlay::create( GLuint sharedVbo, VertexFormat format )
 {
-    destroy();
-
-    glCreateVertexArrays( 1, &vao_ );
-    // bind the shared position VBO at binding=0, stride=3 floats
-    glVertexArrayVertexBuffer( vao_, 0, sharedVbo, 0, sizeof( float ) * 3 );
-    glEnableVertexArrayAttrib( vao_, 0 );
-    glVertexArrayAttribFormat( vao_, 0, 3, GL_FLOAT, GL_FALSE, 0 );
-    glVertexArrayAttribBinding( vao_, 0, 0 );
-
-    glCreateBuffers( 1, &eboSeg_ );
-    glCreateBuffers( 1, &eboArc_ );
+    // cheap to call on every mesh update: the VAOs and buffers are kept,
+    // only the shared VBO binding is refreshed (it changes when the mesh grows)
+    if ( !vao_ )
+    {
+        glCreateVertexArrays( 1, &vao_ );
+        setVertexFormat( vao_, format );
+    }
+    else if ( format != format_ )
+        setVertexFormat( vao_, format );
+    format_ = format;
+    // bind the shared position VBO at binding=0 with the mesh's stride
+    glVertexArrayVertexBuffer( vao_, 0, sharedVbo, 0, vertexStride( format ) );
 }
 
 void PSLGOverlay::uploadSegments( const std::vector<Segment>& segs )
 {
-    if ( !eboSeg_ ) return;
-    segCount_ = static_cast<GLsizei>(segs.size());
-    // indices are pairs of uint32_t
-    glNamedBufferData( eboSeg_, segs.size() * 2 * sizeof( uint32_t ), segs.data(), GL_STATIC_DRAW );
+    static_assert(sizeof( Segment ) == 2 * sizeof( uint32_t ));
+    uploadSegments( reinterpret_cast<const uint32_t*>(segs.data()), segs.size() );
 }
 
-void PSLGOverlay::uploadArcs( const std::vector<Arc>& arcs, int tessPerQuad )
+void PSLGOverlay::uploadSegments( const uint32_t* pairs, size_t count )
 {
-    if ( !eboArc_ ) return;
-
-    std::vector<uint32_t> idx;
-    idx.reserve( arcs.size() * (tessPerQuad * 4 + 1) );
-
-    arcStripStarts_.clear();
-    arcStripCounts_.clear();
+    Trace::Scope trace( "PSLGOverlay::uploadSegments" );
+    if ( !vao_ ) return;
+    segCount_ = static_cast<GLsizei>(count);
+    // indices are pairs of uint32_t; only changed ranges are rewritten
+    segBuf_.update( pairs, count * 2 * sizeof( uint32_t ) );
+}
 
-    for ( const auto& a : arcs )
-    {
-        // compute angle of endpoints around center
-        // NOTE: vertex positions are in the shared VBO; here we only generate indices.
-        // We tessellate as *index* sequence along the arc; simplest: generate new polyline indices
-        // that reference hypothetical tess points. Since we do NOT create tessellated vertices here,
-        // well approximate by interpolating between endpoints using the existing endpoints only.
-        // For a proper arc, you either:
-        //  (A) generate tessellated intermediate *vertices* and put them in a separate VBO, or
-        //  (B) keep endpoints only and draw with a shader/GS (more involved).
-        //
-        // Quick path for milestone: approximate as straight segment for now (visual overlay),
-        // but keep structure ready for real tessellation later.
-        arcStripStarts_.push_back( static_cast<GLuint>(idx.size()) );
-        idx.push_back( a.a );
-        idx.push_back( a.b );
-        arcStripCounts_.push_back( 2 );
-    }
+bool PSLGOverlay::stageSegments( const uint32_t* pairs, size_t count, size_t& budget )
+{
+    Trace::Scope trace( "PSLGOverlay::stageSegments" );
+    return segBuf_.stage( pairs, count * 2 * sizeof( uint32_t ), budget );
+}
 
-    arcIndexCount_ = static_cast<GLsizei>(idx.size());
-    glNamedBufferData( eboArc_, idx.size() * sizeof( uint32_t ), idx.data(), GL_STATIC_DRAW );
+void PSLGOverlay::commitSegments()
+{
+    segBuf_.commit();
+    segCount_ = static_cast<GLsizei>(segBuf_.size() / (2 * sizeof( uint32_t )));
 }
 
 void PSLGOverlay::drawLines()
 {
-    if ( !vao_ || !eboSeg_ || segCount_ == 0 ) return;
+    if ( !vao_ || !segBuf_.id() || segCount_ == 0 ) return;
     glBindVertexArray( vao_ );
-    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, eboSeg_ );
+    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, segBuf_.id() );
     glDrawElements( GL_LINES, segCount_ * 2, GL_UNSIGNED_INT, (void*)0 );
 }
 
-void PSLGOverlay::drawArcs()
+void PSLGOverlay::drawLinesIndirect( GLuint indirectBuf, const void* offset, GLsizei drawCount )
 {
-    if ( !vao_ || !eboArc_ || arcIndexCount_ == 0 ) return;
+    if ( !vao_ || !segBuf_.id() || segCount_ == 0 || drawCount <= 0 ) return;
     glBindVertexArray( vao_ );
-    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, eboArc_ );
-    // We stored each arc as a small strip count; draw each as a line strip
-    size_t offset = 0;
-    for ( size_t i = 0; i < arcStripCounts_.size(); ++i )
-    {
-        glDrawElements( GL_LINE_STRIP, arcStripCounts_[i], GL_UNSIGNED_INT,
-                        (void*)(offset * sizeof( uint32_t )) );
-        offset += arcStripCounts_[i];
-    }
+    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, segBuf_.id() );
+    glBindBuffer( GL_DRAW_INDIRECT_BUFFER, indirectBuf );
+    glMultiDrawElementsIndirect( GL_LINES, GL_UNSIGNED_INT, offset, drawCount, 0 );
 }
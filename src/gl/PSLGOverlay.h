@@ -2,40 +2,38 @@
 #pragma once
 #include <vector>
 #include <cstdint>
+#include <cstddef>
 #include <glad/glad.h>
 
-struct Segment { uint32_t a, b; };
+#include "Shader.h"
+#include "PersistentBuffer.h"
+#include "VertexFormat.h"
 
-struct Arc
-{
-	uint32_t a, b;     // endpoints (indices into vertex array)
-	float cx, cy;      // center
-	float r;           // radius
-	bool ccw;          // direction
-};
+struct Segment { uint32_t a, b; };
 
 class PSLGOverlay
 {
 public:
 	void destroy();
-	void create( GLuint sharedVbo );      // bind the same position VBO as the mesh
+	void create( GLuint sharedVbo, VertexFormat format = VertexFormat::Float3 ); // bind the same VBO as the mesh, same layout
 	void uploadSegments( const std::vector<Segment>& segs );
-	void uploadArcs( const std::vector<Arc>& arcs, int tessPerQuad = 16 );
+	void uploadSegments( const uint32_t* pairs, size_t count ); // count = number of segments
+	// sliced variant, see PersistentBuffer::stage()
+	bool stageSegments( const uint32_t* pairs, size_t count, size_t& budget );
+	void commitSegments();
+	void cancelStage() { segBuf_.cancelStage(); }
 
 	void drawLines();                    // GL_LINES using segments
-	void drawArcs();                     // tessellated arcs as GL_LINE_STRIP(s)
+	void drawLinesIndirect( GLuint indirectBuf, const void* offset, GLsizei drawCount );
 
 	bool hasSegments() const { return segCount_ > 0; }
-	bool hasArcs() const { return arcIndexCount_ > 0; }
 
 	GLuint vao() const { return vao_; }
+	size_t lastUploadBytes() const { return segBuf_.lastUploadBytes(); }
 
 private:
 	GLuint vao_ = 0;
-	GLuint eboSeg_ = 0;                 // segments (uint32 index pairs)
-	GLuint eboArc_ = 0;                 // arcs (tessellated line-strip indices)
+	VertexFormat format_ = VertexFormat::Float3;
+	PersistentBuffer segBuf_;           // segments (uint32 index pairs)
 	GLsizei segCount_ = 0;              // number of lines (pairs)
-	GLsizei arcIndexCount_ = 0;         // total indices for all strips
-	std::vector<GLuint> arcStripStarts_; // offsets per arc (optional for debugging)
-	std::vector<GLsizei> arcStripCounts_;
 };
@@ -0,0 +1,278 @@
+#pragma once
+#include <glad/glad.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <utility>
+#include <vector>
+
+// Persistently mapped GL buffer with dirty-range uploads. update() hashes the
+// new contents in kBlock pieces, compares against the hashes of the last
+// upload and writes only the blocks that changed (plus any growth). Storage
+// is reallocated only when the data outgrows it, doubling each time.
+//
+// Fresh storage is filled straight through the mapping: no draw can be
+// reading it yet. In-place changes to storage that frames in flight may still
+// read go through a small fenced staging ring instead: the bytes land in a
+// ring slice the GPU is done with and are copied into place in command order,
+// so the CPU never waits on the frame being drawn.
+//
+// For wholesale replacements that are too big for one frame, stage() streams
+// the new contents into fresh storage a slice at a time while the current one
+// keeps being drawn; commit() swaps it in and deletes the old storage (GL
+// keeps it alive until the frames that drew from it have finished).
+class PersistentBuffer
+{
+public:
+    static constexpr size_t kBlock = 256;      // diff granularity, bytes
+    static constexpr size_t kRingBytes = size_t( 256 ) << 10;     // staging ring for in-place writes
+
+    PersistentBuffer() = default;
+    // owns GL names and fences; never copied or moved
+    PersistentBuffer( const PersistentBuffer& ) = delete;
+    PersistentBuffer& operator=( const PersistentBuffer& ) = delete;
+    PersistentBuffer( PersistentBuffer&& ) = delete;
+    PersistentBuffer& operator=( PersistentBuffer&& ) = delete;
+
+    ~PersistentBuffer() { destroy(); }
+    void destroy()
+    {
+        release( buf_, ptr_, cap_ );
+        ring_.destroy();
+        size_ = 0;
+        hashes_.clear();
+        cancelStage();
+        uploaded_ = 0;
+    }
+
+    // Returns true when the buffer object was (re)created and must be rebound
+    bool update( const void* data, size_t bytes )
+    {
+        uploaded_ = 0;
+        const auto* src = static_cast<const uint8_t*>(data);
+
+        if ( bytes > cap_ || !buf_ )
+        {
+            const size_t cap = std::max<size_t>( { bytes, cap_ * 2, kBlock } );
+            release( buf_, ptr_, cap_ );
+            allocate( buf_, ptr_, cap_, cap );
+            if ( bytes ) std::memcpy( ptr_, src, bytes );
+            hashes_.resize( blockCount( bytes ) );
+            for ( size_t b = 0; b < hashes_.size(); ++b ) hashes_[b] = hashBlock( src, bytes, b );
+            size_ = bytes;
+            uploaded_ = bytes;
+            return true;
+        }
+
+        // same storage: copy only the blocks whose hash changed
+        const size_t oldSize = size_;
+        hashes_.resize( blockCount( bytes ), kStale );
+        size_t runStart = SIZE_MAX;
+        for ( size_t b = 0; b < hashes_.size(); ++b )
+        {
+            const size_t off = b * kBlock;
+            const uint64_t h = hashBlock( src, bytes, b );
+            // a block that was partial (or absent) before is rewritten whole
+            const bool sameLength = off < oldSize && std::min( kBlock, oldSize - off ) == std::min( kBlock, bytes - off );
+            const bool dirty = !sameLength || hashes_[b] != h;
+            hashes_[b] = h;
+            if ( dirty && runStart == SIZE_MAX ) runStart = off;
+            if ( !dirty && runStart != SIZE_MAX ) { copyIn( runStart, src + runStart, off - runStart ); runStart = SIZE_MAX; }
+        }
+        if ( runStart != SIZE_MAX ) copyIn( runStart, src + runStart, bytes - runStart );
+        ring_.fence();
+
+        size_ = bytes;
+        return false;
+    }
+
+    // Overwrites bytes at offset in place, e.g. one record of an SSBO; the
+    // range must lie within the last update(). Goes through the staging ring
+    // like update(), so it never waits on frames in flight
+    void patch( size_t offset, const void* data, size_t bytes )
+    {
+        uploaded_ = 0;
+        if ( !buf_ || offset + bytes > size_ || !bytes ) return;
+        copyIn( offset, static_cast<const uint8_t*>(data), bytes );
+        ring_.fence();
+        // the blocks no longer match any hash; the next update() rewrites them
+        for ( size_t b = offset / kBlock; b <= (offset + bytes - 1) / kBlock; ++b ) hashes_[b] = kStale;
+    }
+
+    // Writes up to 'budget' more bytes of data into the staging buffer and
+    // takes them off the budget. The same data/bytes must be passed until it
+    // returns true (everything staged); then call commit().
+    bool stage( const void* data, size_t bytes, size_t& budget )
+    {
+        if ( !staging_ )
+        {
+            // never drawn from, so written without waiting
+            allocate( stageBuf_, stagePtr_, stageCap_, std::max( bytes, kBlock ) );
+            stageHashes_.assign( blockCount( bytes ), kStale );
+            stageSize_ = bytes;
+            staged_ = 0;
+            staging_ = true;
+        }
+        const auto* src = static_cast<const uint8_t*>(data);
+        const size_t len = std::min( budget, stageSize_ - staged_ );
+        if ( len )
+        {
+            std::memcpy( stagePtr_ + staged_, src + staged_, len );
+            // hash every block that is now complete
+            const size_t from = staged_ / kBlock;
+            staged_ += len;
+            budget -= len;
+            const size_t to = staged_ == stageSize_ ? stageHashes_.size() : staged_ / kBlock;
+            for ( size_t b = from; b < to; ++b ) stageHashes_[b] = hashBlock( src, stageSize_, b );
+        }
+        return staged_ == stageSize_;
+    }
+
+    // Swaps the staged contents in; id() changes, so rebind afterwards
+    void commit()
+    {
+        release( buf_, ptr_, cap_ );
+        buf_ = std::exchange( stageBuf_, 0 );
+        ptr_ = std::exchange( stagePtr_, nullptr );
+        cap_ = std::exchange( stageCap_, 0 );
+        hashes_.swap( stageHashes_ );
+        stageHashes_ = {};
+        size_ = stageSize_;
+        uploaded_ = size_;
+        staging_ = false;
+        staged_ = stageSize_ = 0;
+    }
+
+    // drop a partial stage and its storage; the next stage() starts over
+    void cancelStage()
+    {
+        release( stageBuf_, stagePtr_, stageCap_ );
+        stageHashes_ = {};
+        staging_ = false;
+        staged_ = stageSize_ = 0;
+    }
+
+    GLuint id() const { return buf_; }
+    size_t size() const { return size_; }
+    size_t capacity() const { return cap_; }
+    size_t lastUploadBytes() const { return uploaded_; }
+
+private:
+    static constexpr uint64_t kStale = 0;      // hashBlock() never returns it
+
+    static size_t blockCount( size_t bytes ) { return (bytes + kBlock - 1) / kBlock; }
+
+    // FNV-1a over 8-byte words with a shift mix; block b of data[0 .. bytes)
+    static uint64_t hashBlock( const uint8_t* data, size_t bytes, size_t b )
+    {
+        const uint8_t* p = data + b * kBlock;
+        const size_t len = std::min( kBlock, bytes - b * kBlock );
+        uint64_t h = 1469598103934665603ull;
+        size_t i = 0;
+        for ( ; i + 8 <= len; i += 8 )
+        {
+            uint64_t w;
+            std::memcpy( &w, p + i, 8 );
+            h = (h ^ w) * 1099511628211ull;
+            h ^= h >> 29;
+        }
+        for ( ; i < len; ++i ) h = (h ^ p[i]) * 1099511628211ull;
+        return h | 1;
+    }
+
+    static void allocate( GLuint& buf, uint8_t*& ptr, size_t& cap, size_t bytes )
+    {
+        const GLbitfield flags = GL_DYNAMIC_STORAGE_BIT | GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        cap = bytes;
+        glCreateBuffers( 1, &buf );
+        glNamedBufferStorage( buf, GLsizeiptr( cap ), nullptr, flags );
+        ptr = static_cast<uint8_t*>(glMapNamedBufferRange( buf, 0, GLsizeiptr( cap ),
+                                                           GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT ));
+    }
+    static void release( GLuint& buf, uint8_t*& ptr, size_t& cap )
+    {
+        if ( buf )
+        {
+            glUnmapNamedBuffer( buf );
+            glDeleteBuffers( 1, &buf );
+        }
+        buf = 0; ptr = nullptr; cap = 0;
+    }
+
+    // In-place write into storage that may be in flight. Large runs go through
+    // glNamedBufferSubData and the driver's own staging; the ring would only
+    // wrap onto itself within one update.
+    void copyIn( size_t offset, const uint8_t* src, size_t len )
+    {
+        uploaded_ += len;
+        if ( len > kRingBytes / 4 )
+        {
+            glNamedBufferSubData( buf_, GLintptr( offset ), GLsizeiptr( len ), src );
+            return;
+        }
+        const size_t at = ring_.reserve( len );
+        std::memcpy( ring_.ptr + at, src, len );
+        glCopyNamedBufferSubData( ring_.buf, buf_, GLintptr( at ), GLintptr( offset ), GLsizeiptr( len ) );
+    }
+
+    // Staging ring: slices are handed out in order, and every batch of copies
+    // is fenced; a slice is reused only once the fence of the batch that last
+    // used it has signalled, which is long past by the time the ring wraps.
+    struct Ring
+    {
+        GLuint buf = 0;
+        uint8_t* ptr = nullptr;
+        size_t cap = 0, head = 0, open = 0;     // open: start of the unfenced batch
+        struct Span { size_t begin, end; GLsync fence; };
+        std::deque<Span> spans;                 // oldest first
+
+        size_t reserve( size_t len )
+        {
+            if ( !buf ) allocate( buf, ptr, cap, kRingBytes );
+            len = (len + 15) & ~size_t( 15 );
+            if ( head + len > cap )
+            {
+                fence();
+                head = open = 0;
+            }
+            while ( !spans.empty() && spans.front().begin < head + len && head < spans.front().end )
+            {
+                glClientWaitSync( spans.front().fence, GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64( 1000000000 ) );
+                glDeleteSync( spans.front().fence );
+                spans.pop_front();
+            }
+            const size_t at = head;
+            head += len;
+            return at;
+        }
+        // after the copies reading [open, head) have been issued
+        void fence()
+        {
+            if ( head == open ) return;
+            spans.push_back( { open, head, glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 ) } );
+            open = head;
+        }
+        void destroy()
+        {
+            for ( auto& s : spans ) glDeleteSync( s.fence );
+            spans.clear();
+            release( buf, ptr, cap );
+            head = open = 0;
+        }
+    };
+
+    GLuint buf_ = 0;
+    uint8_t* ptr_ = nullptr;
+    size_t cap_ = 0, size_ = 0;
+    std::vector<uint64_t> hashes_;      // per kBlock of the last upload
+    size_t uploaded_ = 0;
+    Ring ring_;
+
+    // storage being filled by stage(); none between stages
+    GLuint stageBuf_ = 0;
+    uint8_t* stagePtr_ = nullptr;
+    size_t stageCap_ = 0, stageSize_ = 0, staged_ = 0;
+    bool staging_ = false;
+    std::vector<uint64_t> stageHashes_;
+};
@@ -2,17 +2,41 @@
 #include <glad/glad.h>
 #include <cstdint>
 
+// What a pick id refers to; stored in the top bits of the R32UI id target
+enum class PickKind : uint32_t
+{
+    None = 0,
+    Triangle = 1,
+    Edge = 2,
+    Node = 3
+};
+
+struct PickResult
+{
+    PickKind kind = PickKind::None;
+    uint32_t id = 0;            // 0-based primitive index within its kind
+    bool hit() const { return kind != PickKind::None; }
+};
+
+// Reads go through a small ring of pixel pack buffers, each fenced, and are
+// collected on a later frame with poll(); nothing here waits on the GPU.
 class Picker
 {
 public:
+    // id layout: [31..28] kind, [27..0] primitive + 1 (0 = no hit)
+    static constexpr uint32_t kKindShift = 28u;
+    static constexpr uint32_t kIdMask = (1u << kKindShift) - 1u;
+    static constexpr int kReads = 4;    // clicks in flight before the oldest is dropped
+
     ~Picker() { destroy(); }
+    // the targets are kept while the size is unchanged
     void create( int w, int h )
     {
         if ( w == w_ && h == h_ && fbo_ ) return;
-        destroy();
+        destroyTargets();
         w_ = w; h_ = h;
         glCreateTextures( GL_TEXTURE_2D, 1, &tex_ );
-        glTextureStorage2D( tex_, 1, GL_RGBA8, w_, h_ );
+        glTextureStorage2D( tex_, 1, GL_R32UI, w_, h_ );
         glCreateRenderbuffers( 1, &rbo_ );
         glNamedRenderbufferStorage( rbo_, GL_DEPTH24_STENCIL8, w_, h_ );
         glCreateFramebuffers( 1, &fbo_ );
@@ -20,6 +44,17 @@ public:
         glNamedFramebufferRenderbuffer( fbo_, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, rbo_ );
     }
     void destroy()
+    {
+        destroyTargets();
+        for ( Read& r : reads_ )
+        {
+            if ( r.fence ) glDeleteSync( r.fence );
+            if ( r.pbo ) glDeleteBuffers( 1, &r.pbo );
+            r = {};
+        }
+        head_ = count_ = 0;
+    }
+    void destroyTargets()
     {
         if ( fbo_ ) glDeleteFramebuffers( 1, &fbo_ );
         if ( rbo_ ) glDeleteRenderbuffers( 1, &rbo_ );
@@ -30,19 +65,74 @@ public:
     {
         glBindFramebuffer( GL_FRAMEBUFFER, fbo_ );
         glViewport( 0, 0, w_, h_ );
-        glClearColor( 0, 0, 0, 0 );
-        glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+        // integer attachment: glClearColor does not apply
+        const GLuint zero[4] = { 0, 0, 0, 0 };
+        glClearNamedFramebufferuiv( fbo_, GL_COLOR, 0, zero );
+        glClear( GL_DEPTH_BUFFER_BIT );
     }
     void end() { glBindFramebuffer( GL_FRAMEBUFFER, 0 ); }
-    uint32_t read( int x, int y )
-    { // window coords mapped to FBO size beforehand
-        unsigned char rgba[4]{};
-        glBindFramebuffer( GL_FRAMEBUFFER, fbo_ );
-        glReadPixels( x, y, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, rgba );
-        glBindFramebuffer( GL_FRAMEBUFFER, 0 );
-        return (uint32_t( rgba[0] ) << 16) | (uint32_t( rgba[1] ) << 8) | uint32_t( rgba[2] );
+
+    // Queues a copy of the id at (x, y) into a buffer and fences it; tag comes
+    // back from poll() so the caller can tell which click, and which mesh, it
+    // was for. Window coords mapped to FBO size beforehand.
+    bool requestRead( int x, int y, uint64_t tag )
+    {
+        if ( !fbo_ || x < 0 || y < 0 || x >= w_ || y >= h_ ) return false;
+        if ( count_ == kReads ) drop();
+        Read& r = reads_[(head_ + count_) % kReads];
+        if ( !r.pbo )
+        {
+            glCreateBuffers( 1, &r.pbo );
+            glNamedBufferStorage( r.pbo, sizeof( GLuint ), nullptr, GL_CLIENT_STORAGE_BIT );
+        }
+        glBindFramebuffer( GL_READ_FRAMEBUFFER, fbo_ );
+        glBindBuffer( GL_PIXEL_PACK_BUFFER, r.pbo );
+        glReadPixels( x, y, 1, 1, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr );
+        glBindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+        glBindFramebuffer( GL_READ_FRAMEBUFFER, 0 );
+        r.fence = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+        r.tag = tag;
+        ++count_;
+        return true;
+    }
+
+    // the oldest queued read, if its fence has signaled; never blocks
+    bool poll( PickResult& out, uint64_t& tag )
+    {
+        if ( count_ == 0 ) return false;
+        Read& r = reads_[head_];
+        GLint status = GL_UNSIGNALED;
+        glGetSynciv( r.fence, GL_SYNC_STATUS, 1, nullptr, &status );
+        if ( status != GL_SIGNALED ) return false;
+        GLuint raw = 0;
+        glGetNamedBufferSubData( r.pbo, 0, sizeof( raw ), &raw );
+        out = decode( raw );
+        tag = r.tag;
+        drop();
+        return true;
+    }
+    bool pending() const { return count_ > 0; }
+
+    static PickResult decode( uint32_t raw )
+    {
+        const uint32_t id = raw & kIdMask;
+        if ( id == 0 ) return {};
+        return { PickKind( raw >> kKindShift ), id - 1 };
     }
     int w() const { return w_; } int h() const { return h_; }
 private:
+    struct Read { GLuint pbo = 0; GLsync fence = nullptr; uint64_t tag = 0; };
+
+    void drop()
+    {
+        Read& r = reads_[head_];
+        glDeleteSync( r.fence );
+        r.fence = nullptr;
+        head_ = (head_ + 1) % kReads;
+        --count_;
+    }
+
     GLuint fbo_ = 0, tex_ = 0, rbo_ = 0; int w_ = 0, h_ = 0;
+    Read reads_[kReads];
+    int head_ = 0, count_ = 0;
 };
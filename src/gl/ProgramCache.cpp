@@ -0,0 +1,162 @@
+// ProgramCache.cpp
+#include "ProgramCache.h"
+#include "../mesh/Trace.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    constexpr char kMagic[8] = { 'Q', 'M', 'V', 'P', 'R', 'O', 'G', 'B' };
+    constexpr uint32_t kVersion = 1;
+
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t headerBytes;
+        uint64_t key;           // repeated from the file name
+        uint32_t format;        // GLenum from glGetProgramBinary
+        uint32_t length;        // binary bytes following the header
+    };
+
+    fs::path dir_;
+    ProgramCache::Stats stats_;
+
+    // FNV-1a; the terminating zeros keep ("ab","c") and ("a","bc") apart
+    uint64_t keyOf( const char* vsSrc, const char* fsSrc )
+    {
+        uint64_t h = 1469598103934665603ull;
+        auto mix = [&]( const char* s )
+            {
+                if ( s )
+                    for ( ; *s; ++s ) { h ^= uint8_t( *s ); h *= 1099511628211ull; }
+                h *= 1099511628211ull;
+            };
+        mix( vsSrc );
+        mix( fsSrc );
+        for ( GLenum e : { GL_VENDOR, GL_RENDERER, GL_VERSION } )
+            mix( reinterpret_cast<const char*>(glGetString( e )) );
+        return h;
+    }
+
+    fs::path pathFor( uint64_t key )
+    {
+        char name[32];
+        std::snprintf( name, sizeof( name ), "%016llx.bin", static_cast<unsigned long long>(key) );
+        return dir_ / name;
+    }
+
+    bool supported()
+    {
+        GLint formats = 0;
+        glGetIntegerv( GL_NUM_PROGRAM_BINARY_FORMATS, &formats );
+        return formats > 0;
+    }
+
+    struct Timer
+    {
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        ~Timer() { stats_.ms += std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - t0 ).count(); }
+    };
+}
+
+void ProgramCache::setDirectory( const fs::path& dir )
+{
+    dir_ = dir;
+}
+
+const ProgramCache::Stats& ProgramCache::stats()
+{
+    return stats_;
+}
+
+GLuint ProgramCache::load( const char* vsSrc, const char* fsSrc )
+{
+    if ( dir_.empty() || !supported() ) return 0;
+    Trace::Scope trace( "ProgramCache::load" );
+    Timer timer;
+
+    const uint64_t key = keyOf( vsSrc, fsSrc );
+    const fs::path path = pathFor( key );
+    std::error_code ec;
+    const uintmax_t fileBytes = fs::file_size( path, ec );
+    std::ifstream in( path, std::ios::binary );
+    Header h{};
+    // the binary must fill the rest of the file exactly; a truncated or padded
+    // file is a miss before anything is allocated for it
+    if ( ec || !in || !in.read( reinterpret_cast<char*>(&h), sizeof( h ) )
+         || std::memcmp( h.magic, kMagic, sizeof( kMagic ) ) != 0
+         || h.version != kVersion || h.headerBytes != sizeof( Header ) || h.key != key
+         || fileBytes != sizeof( Header ) + uintmax_t( h.length ) )
+    {
+        ++stats_.misses;
+        return 0;
+    }
+    std::vector<char> binary( h.length );
+    if ( !in.read( binary.data(), std::streamsize( binary.size() ) ) )
+    {
+        ++stats_.misses;
+        return 0;
+    }
+
+    GLuint prog = glCreateProgram();
+    glProgramBinary( prog, GLenum( h.format ), binary.data(), GLsizei( binary.size() ) );
+    GLint ok = 0;
+    glGetProgramiv( prog, GL_LINK_STATUS, &ok );
+    if ( !ok )
+    {
+        // rejected (driver rebuilt with the same strings); store() replaces it
+        glDeleteProgram( prog );
+        ++stats_.misses;
+        return 0;
+    }
+    ++stats_.hits;
+    return prog;
+}
+
+bool ProgramCache::store( GLuint prog, const char* vsSrc, const char* fsSrc )
+{
+    if ( dir_.empty() || !supported() ) return false;
+    Trace::Scope trace( "ProgramCache::store" );
+    Timer timer;
+
+    GLint length = 0;
+    glGetProgramiv( prog, GL_PROGRAM_BINARY_LENGTH, &length );
+    if ( length <= 0 ) return false;
+    std::vector<char> binary( static_cast<size_t>(length) );
+    GLenum format = 0;
+    glGetProgramBinary( prog, length, &length, &format, binary.data() );
+    if ( length <= 0 ) return false;
+
+    Header h{};
+    std::memcpy( h.magic, kMagic, sizeof( kMagic ) );
+    h.version = kVersion;
+    h.headerBytes = sizeof( Header );
+    h.key = keyOf( vsSrc, fsSrc );
+    h.format = format;
+    h.length = uint32_t( length );
+
+    std::error_code ec;
+    fs::create_directories( dir_, ec );
+    const fs::path dst = pathFor( h.key );
+    fs::path tmp = dst;
+    tmp += ".tmp";
+    {
+        std::ofstream out( tmp, std::ios::binary | std::ios::trunc );
+        if ( !out ) return false;
+        out.write( reinterpret_cast<const char*>(&h), sizeof( h ) );
+        out.write( binary.data(), length );
+        if ( !out ) { out.close(); fs::remove( tmp, ec ); return false; }
+    }
+    fs::rename( tmp, dst, ec );
+    if ( ec ) { fs::remove( tmp, ec ); return false; }
+    ++stats_.stores;
+    return true;
+}
@@ -0,0 +1,33 @@
+// ProgramCache.h
+#pragma once
+#include <cstddef>
+#include <filesystem>
+#include <glad/glad.h>
+
+// On-disk cache of linked program binaries (glGetProgramBinary), so startup
+// skips compiling and linking every shader, which is slow on software GL.
+// One file per program, named after a hash of both sources and the
+// GL_VENDOR/GL_RENDERER/GL_VERSION strings; a driver update changes the
+// name, and a binary the driver still rejects is dropped and rebuilt.
+// Disabled until a directory is set or when the driver offers no formats.
+namespace ProgramCache
+{
+	struct Stats
+	{
+		size_t hits = 0;
+		size_t misses = 0;
+		size_t stores = 0;
+		double ms = 0;          // time spent in load() + store()
+	};
+
+	// per-user directory, created on first store; empty disables the cache
+	void setDirectory( const std::filesystem::path& dir );
+	const Stats& stats();
+
+	// a linked program, or 0 on a miss; needs a current context
+	GLuint load( const char* vsSrc, const char* fsSrc );
+
+	// writes to a temp file and renames it over the old entry; the program
+	// should have been linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+	bool store( GLuint prog, const char* vsSrc, const char* fsSrc );
+}
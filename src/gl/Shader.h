@@ -1,17 +1,30 @@
 #pragma once
+#include <cstring>
 #include <string>
 #include <stdexcept>
+#include <utility>
+#include <vector>
 #include <glad/glad.h>
 
+#include "ProgramCache.h"
+
 class Shader
 {
 public:
     Shader() = default;
     ~Shader() { if ( prog_ ) glDeleteProgram( prog_ ); }
 
-    // throws on error
+    // throws on error; a previous program is replaced. A binary from
+    // ProgramCache skips compile and link; otherwise the result is stored.
     void build( const char* vsSrc, const char* fsSrc )
     {
+        if ( prog_ ) glDeleteProgram( prog_ ), prog_ = 0;
+        if ( (prog_ = ProgramCache::load( vsSrc, fsSrc )) != 0 )
+        {
+            cacheLocations();
+            return;
+        }
+
         GLuint vs = glCreateShader( GL_VERTEX_SHADER );
         GLuint fs = glCreateShader( GL_FRAGMENT_SHADER );
         glShaderSource( vs, 1, &vsSrc, nullptr );
@@ -22,36 +35,82 @@ public:
         prog_ = glCreateProgram();
         glAttachShader( prog_, vs );
         glAttachShader( prog_, fs );
+        glProgramParameteri( prog_, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE );
         glLinkProgram( prog_ );
         glDeleteShader( vs );
         glDeleteShader( fs );
         checkProgram();
+        ProgramCache::store( prog_, vsSrc, fsSrc );
+        cacheLocations();
     }
 
     void use() const { glUseProgram( prog_ ); }
     GLuint id() const { return prog_; }
 
-    // Uniform helpers (use DSA when available)
+    // location resolved at link time; -1 when the program has no such uniform
+    GLint location( const char* name ) const
+    {
+        for ( const auto& [n, loc] : locations_ )
+            if ( n == name ) return loc;
+        return -1;
+    }
+
+    // Uniform helpers (DSA: the program need not be bound)
     void setVec4( const char* name, const float* v ) const
     {
-        GLint loc = glGetUniformLocation( prog_, name );
-        if ( loc != -1 ) glUniform4fv( loc, 1, v );
+        GLint loc = location( name );
+        if ( loc != -1 ) glProgramUniform4fv( prog_, loc, 1, v );
+    }
+
+    void setVec2( const char* name, float x, float y ) const
+    {
+        GLint loc = location( name );
+        if ( loc != -1 ) glProgramUniform2f( prog_, loc, x, y );
     }
 
     void setFloat( const char* name, const float v ) const
     {
-        GLint loc = glGetUniformLocation( prog_, name );
-        if ( loc != -1 ) glUniform4fv( loc, 1, &v );
+        GLint loc = location( name );
+        if ( loc != -1 ) glProgramUniform1f( prog_, loc, v );
+    }
+
+    void setInt( const char* name, const GLint v ) const
+    {
+        GLint loc = location( name );
+        if ( loc != -1 ) glProgramUniform1i( prog_, loc, v );
+    }
+
+    void setUInt( const char* name, const GLuint v ) const
+    {
+        GLint loc = location( name );
+        if ( loc != -1 ) glProgramUniform1ui( prog_, loc, v );
     }
 
     void setMat4( const char* name, const float* m ) const
     {
-        GLint loc = glGetUniformLocation( prog_, name );
-        if ( loc != -1 ) glUniformMatrix4fv( loc, 1, GL_FALSE, m );
+        GLint loc = location( name );
+        if ( loc != -1 ) glProgramUniformMatrix4fv( prog_, loc, 1, GL_FALSE, m );
     }
 
 private:
     GLuint prog_ = 0;
+    std::vector<std::pair<std::string, GLint>> locations_;  // default-block uniforms
+
+    void cacheLocations()
+    {
+        locations_.clear();
+        GLint count = 0;
+        glGetProgramInterfaceiv( prog_, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count );
+        for ( GLint i = 0; i < count; ++i )
+        {
+            char name[256];
+            glGetProgramResourceName( prog_, GL_UNIFORM, GLuint( i ), sizeof( name ), nullptr, name );
+            const GLint loc = glGetProgramResourceLocation( prog_, GL_UNIFORM, name );
+            if ( loc < 0 ) continue;    // block members
+            if ( char* bracket = std::strstr( name, "[0]" ) ) *bracket = '\0';
+            locations_.emplace_back( name, loc );
+        }
+    }
 
     void checkShader( GLuint s, const char* what )
     {
@@ -0,0 +1,27 @@
+// VertexFormat.h
+#pragma once
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+
+// Layouts of the shared mesh VBO. Float3 is xyz in world units; Unorm16x2 is
+// xy in steps of the mesh lattice from the cell of the chunk the vertex
+// belongs to (see MeshChunks::localize), decoded in the vertex shader from
+// the chunk table.
+enum class VertexFormat { Float3, Unorm16x2 };
+
+inline GLsizei vertexStride( VertexFormat f )
+{
+    return f == VertexFormat::Unorm16x2 ? GLsizei( 2 * sizeof( uint16_t ) ) : GLsizei( 3 * sizeof( float ) );
+}
+
+// attribute 0 at binding 0; z reads as 0 for the 2-component layout
+inline void setVertexFormat( GLuint vao, VertexFormat f )
+{
+    glEnableVertexArrayAttrib( vao, 0 );
+    if ( f == VertexFormat::Unorm16x2 )
+        glVertexArrayAttribFormat( vao, 0, 2, GL_UNSIGNED_SHORT, GL_TRUE, 0 );
+    else
+        glVertexArrayAttribFormat( vao, 0, 3, GL_FLOAT, GL_FALSE, 0 );
+    glVertexArrayAttribBinding( vao, 0, 0 );
+}
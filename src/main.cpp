@@ -1,11 +1,34 @@
 #include <wx/wx.h>
 #include "MainFrame.h"
+#include "mesh/MeshLoader.h"
+#include "mesh/MeshChunks.h"
+#include "mesh/Trace.h"
+
+#include <cstdio>
 
 class App : public wxApp
 {
 public:
 	bool OnInit() override
 	{
+		// QMVision --build-cache <dir>: write .qmvc caches for every mesh under dir, then exit
+		for ( int i = 1; i + 1 < argc; ++i )
+			if ( wxString( argv[i] ) == "--build-cache" )
+				return batch( BuildCaches( std::filesystem::path( argv[i + 1].ToStdWstring() ) ) );
+		// QMVision --trace <file.json>: record from startup, written on exit
+		for ( int i = 1; i + 1 < argc; ++i )
+			if ( wxString( argv[i] ) == "--trace" )
+			{
+				tracePath_ = std::string( wxString( argv[i + 1] ).ToUTF8() );
+				Trace::setEnabled( true );
+			}
+		Trace::setThreadName( "UI" );
+
+		// QMVision --bench-order <mesh>: vertex cache efficiency before/after the reorder pass
+		for ( int i = 1; i + 1 < argc; ++i )
+			if ( wxString( argv[i] ) == "--bench-order" )
+				return batch( BenchOrder( std::filesystem::path( argv[i + 1].ToStdWstring() ) ) );
+
 #ifdef _WIN32
 #ifdef _DEBUG
         // Open a console window for stdout/stderr in Debug GUI builds
@@ -26,8 +49,69 @@ public:
 		return true;
 	}
 
+    // batch mode: print to the console the app was started from, if any
+    static void AttachParentConsole()
+    {
+#ifdef _WIN32
+        if ( AttachConsole( ATTACH_PARENT_PROCESS ) )
+        {
+            FILE* f;
+            freopen_s( &f, "CONOUT$", "w", stdout );
+        }
+#endif
+    }
+
+    // batch mode: no window, and OnRun() exits with the outcome
+    bool batch( bool ok )
+    {
+        batch_ = true;
+        exitCode_ = ok ? 0 : 1;
+        return true;
+    }
+
+    int OnRun() override
+    {
+        return batch_ ? exitCode_ : wxApp::OnRun();
+    }
+
+    // true when every mesh under dir has a fresh cache afterwards
+    bool BuildCaches( const std::filesystem::path& dir )
+    {
+        AttachParentConsole();
+        size_t seen = 0, failed = 0;
+        const size_t built = MeshLoader::buildCaches( dir, [&]( const std::filesystem::path& p, bool ok )
+            {
+                ++seen;
+                failed += !ok;
+                std::printf( "%s %s\n", ok ? "ok  " : "FAIL", p.string().c_str() );
+            } );
+        std::printf( "%zu meshes, %zu caches written, %zu failed\n", seen, built, failed );
+        return failed == 0;
+    }
+
+    // true when the mesh loaded and was measured
+    bool BenchOrder( const std::filesystem::path& mesh )
+    {
+        AttachParentConsole();
+        const auto r = MeshLoader::load( mesh, true );
+        if ( !r.snapshot )
+        {
+            std::printf( "FAIL %s\n", mesh.string().c_str() );
+            return false;
+        }
+        MeshChunks chunks;
+        chunks.build( *r.snapshot );
+        chunks.reorder( *r.snapshot );
+        std::printf( "%s: %zu triangles in %zu chunks\n", mesh.string().c_str(), chunks.primOfGpu.size(), chunks.chunks.size() );
+        std::printf( "vertices shaded per triangle (FIFO %zu): %.3f -> %.3f, reorder %.1f ms\n",
+                     MeshChunks::kVertexCache, chunks.order.acmrBefore, chunks.order.acmrAfter, chunks.order.ms );
+        return true;
+    }
+
     int OnExit() override
     {
+        if ( !tracePath_.empty() )
+            Trace::write( tracePath_ );
 #ifdef _WIN32
 #ifdef _DEBUG
         // Close the console when the app exits
@@ -36,5 +120,10 @@ public:
 #endif
         return wxApp::OnExit();
     }
+
+private:
+    std::string tracePath_;
+    bool batch_ = false;
+    int exitCode_ = 0;
 };
 wxIMPLEMENT_APP( App );
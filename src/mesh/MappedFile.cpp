@@ -0,0 +1,66 @@
+// MappedFile.cpp
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+bool MappedFile::open( const std::filesystem::path& p )
+{
+    close();
+#ifdef _WIN32
+    HANDLE f = CreateFileW( p.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr );
+    if ( f == INVALID_HANDLE_VALUE ) return false;
+    LARGE_INTEGER sz{};
+    if ( !GetFileSizeEx( f, &sz ) ) { CloseHandle( f ); return false; }
+    file_ = f;
+    size_ = size_t( sz.QuadPart );
+    if ( size_ > 0 )
+    {
+        mapping_ = CreateFileMappingW( f, nullptr, PAGE_READONLY, 0, 0, nullptr );
+        if ( !mapping_ ) { close(); return false; }
+        data_ = static_cast<const uint8_t*>(MapViewOfFile( mapping_, FILE_MAP_READ, 0, 0, 0 ));
+        if ( !data_ ) { close(); return false; }
+    }
+#else
+    fd_ = ::open( p.c_str(), O_RDONLY );
+    if ( fd_ < 0 ) return false;
+    struct stat st {};
+    if ( fstat( fd_, &st ) != 0 ) { close(); return false; }
+    size_ = size_t( st.st_size );
+    if ( size_ > 0 )
+    {
+        void* m = mmap( nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0 );
+        if ( m == MAP_FAILED ) { close(); return false; }
+        madvise( m, size_, MADV_SEQUENTIAL );
+        data_ = static_cast<const uint8_t*>(m);
+    }
+#endif
+    open_ = true;
+    return true;
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+    if ( data_ ) UnmapViewOfFile( data_ );
+    if ( mapping_ ) CloseHandle( mapping_ );
+    if ( file_ ) CloseHandle( file_ );
+    mapping_ = file_ = nullptr;
+#else
+    if ( data_ ) munmap( const_cast<uint8_t*>(data_), size_ );
+    if ( fd_ >= 0 ) ::close( fd_ );
+    fd_ = -1;
+#endif
+    data_ = nullptr;
+    size_ = 0;
+    open_ = false;
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+// Read-only memory mapping of a whole file (Win32 file mapping / POSIX mmap)
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	explicit MappedFile( const std::filesystem::path& p ) { open( p ); }
+	~MappedFile() { close(); }
+	MappedFile( const MappedFile& ) = delete;
+	MappedFile& operator=( const MappedFile& ) = delete;
+
+	bool open( const std::filesystem::path& p );
+	void close();
+
+	bool isOpen() const { return open_; }
+	const uint8_t* data() const { return data_; }
+	size_t size() const { return size_; }
+
+private:
+	bool open_ = false;
+	const uint8_t* data_ = nullptr;
+	size_t size_ = 0;
+#ifdef _WIN32
+	void* file_ = nullptr;
+	void* mapping_ = nullptr;
+#else
+	int fd_ = -1;
+#endif
+};
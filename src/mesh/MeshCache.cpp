@@ -0,0 +1,202 @@
+// MeshCache.cpp
+#include "MeshCache.h"
+#include "MappedFile.h"
+#include "Trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    constexpr char kMagic[8] = { 'Q', 'M', 'V', 'C', 'A', 'C', 'H', 'E' };
+    constexpr uint32_t kVersion = 1;
+
+    // Fixed little-endian layout; arrays follow in this order, each starting
+    // on an 8-byte boundary: x, y (double), ids, tris, quads, edges (uint32)
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t headerBytes;
+        uint64_t srcSize;
+        int64_t srcMtime;
+        uint64_t srcHash;
+        uint64_t nodes, tris, quads, edges;     // element counts, not array lengths
+        uint64_t skipped;
+        double minX, minY, maxX, maxY;
+    };
+
+    size_t align8( size_t n ) { return (n + 7) & ~size_t( 7 ); }
+
+    struct Layout
+    {
+        size_t x, y, ids, tris, quads, edges, total;
+    };
+
+    Layout layoutOf( const Header& h )
+    {
+        Layout l{};
+        size_t at = align8( sizeof( Header ) );
+        auto take = [&]( size_t bytes ) { const size_t o = at; at = align8( at + bytes ); return o; };
+        l.x = take( h.nodes * sizeof( double ) );
+        l.y = take( h.nodes * sizeof( double ) );
+        l.ids = take( h.nodes * sizeof( uint32_t ) );
+        l.tris = take( h.tris * 3 * sizeof( uint32_t ) );
+        l.quads = take( h.quads * 4 * sizeof( uint32_t ) );
+        l.edges = take( h.edges * 2 * sizeof( uint32_t ) );
+        l.total = at;
+        return l;
+    }
+
+    // FNV-1a over the whole file when small, otherwise over 64 evenly spaced
+    // 4 KB blocks (first and last included). Catches edits that keep the size
+    // and restore the mtime without reading a multi-GB file.
+    uint64_t sampledHash( const uint8_t* p, size_t n )
+    {
+        uint64_t h = 1469598103934665603ull;
+        auto mix = [&]( const uint8_t* b, size_t len )
+            {
+                for ( size_t i = 0; i < len; ++i ) { h ^= b[i]; h *= 1099511628211ull; }
+            };
+        constexpr size_t kBlock = 4096, kBlocks = 64;
+        if ( n <= kBlock * kBlocks )
+            mix( p, n );
+        else
+            for ( size_t i = 0; i < kBlocks; ++i )
+                mix( p + (n - kBlock) * i / (kBlocks - 1), kBlock );
+        mix( reinterpret_cast<const uint8_t*>(&n), sizeof( n ) );
+        return h;
+    }
+
+    bool headerMatches( const MappedFile& f, const MeshCache::Key& key, Header& h )
+    {
+        if ( f.size() < sizeof( Header ) ) return false;
+        std::memcpy( &h, f.data(), sizeof( Header ) );
+        if ( std::memcmp( h.magic, kMagic, sizeof( kMagic ) ) != 0
+             || h.version != kVersion || h.headerBytes != sizeof( Header )
+             || h.srcSize != key.size || h.srcMtime != key.mtime || h.srcHash != key.hash )
+            return false;
+        // every section must fit the file on its own before the sizes are
+        // added up, or a corrupt count could wrap the total around
+        const uint64_t n = f.size();
+        if ( h.nodes > n / sizeof( double ) || h.tris > n / (3 * sizeof( uint32_t ))
+             || h.quads > n / (4 * sizeof( uint32_t )) || h.edges > n / (2 * sizeof( uint32_t )) )
+            return false;
+        return layoutOf( h ).total == n;
+    }
+
+    // node indices past the node count would be read out of bounds later
+    bool indicesValid( const std::vector<uint32_t>& idx, size_t nodes )
+    {
+        return std::all_of( idx.begin(), idx.end(), [nodes]( uint32_t v ) { return v < nodes; } );
+    }
+
+    template<class T>
+    void copyOut( std::vector<T>& v, const MappedFile& f, size_t offset, size_t count )
+    {
+        v.resize( count );
+        if ( count ) std::memcpy( v.data(), f.data() + offset, count * sizeof( T ) );
+    }
+}
+
+fs::path MeshCache::pathFor( const fs::path& mesh )
+{
+    fs::path p = mesh;
+    p += ".qmvc";
+    return p;
+}
+
+bool MeshCache::keyOf( const fs::path& mesh, Key& key )
+{
+    std::error_code ec;
+    const auto t = fs::last_write_time( mesh, ec );
+    if ( ec ) return false;
+    MappedFile f( mesh );
+    if ( !f.isOpen() ) return false;
+    key.size = f.size();
+    key.mtime = int64_t( t.time_since_epoch().count() );
+    key.hash = sampledHash( f.data(), f.size() );
+    return true;
+}
+
+bool MeshCache::fresh( const fs::path& mesh, const Key& key )
+{
+    MappedFile f( pathFor( mesh ) );
+    Header h;
+    return f.isOpen() && headerMatches( f, key, h );
+}
+
+std::shared_ptr<MeshSnapshot> MeshCache::load( const fs::path& mesh, const Key& key )
+{
+    Trace::Scope trace( "MeshCache::load" );
+    const auto t0 = std::chrono::steady_clock::now();
+    MappedFile f( pathFor( mesh ) );
+    Header h;
+    if ( !f.isOpen() || !headerMatches( f, key, h ) ) return nullptr;
+
+    const Layout l = layoutOf( h );
+    auto snap = std::make_shared<MeshSnapshot>();
+    auto& s = *snap;
+    copyOut( s.x, f, l.x, h.nodes );
+    copyOut( s.y, f, l.y, h.nodes );
+    copyOut( s.ids, f, l.ids, h.nodes );
+    copyOut( s.tris, f, l.tris, h.tris * 3 );
+    copyOut( s.quads, f, l.quads, h.quads * 4 );
+    copyOut( s.edges, f, l.edges, h.edges * 2 );
+    if ( !indicesValid( s.tris, s.nodeCount() ) || !indicesValid( s.quads, s.nodeCount() )
+         || !indicesValid( s.edges, s.nodeCount() ) )
+        return nullptr;     // corrupt; the caller parses the mesh instead
+    s.minX = h.minX; s.minY = h.minY; s.maxX = h.maxX; s.maxY = h.maxY;
+
+    s.stats.skippedElements = size_t( h.skipped );
+    s.stats.fromCache = true;
+    s.stats.cacheMs = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - t0 ).count();
+    return snap;
+}
+
+bool MeshCache::store( const fs::path& mesh, const Key& key, const MeshSnapshot& s )
+{
+    Trace::Scope trace( "MeshCache::store" );
+    Header h{};
+    std::memcpy( h.magic, kMagic, sizeof( kMagic ) );
+    h.version = kVersion;
+    h.headerBytes = sizeof( Header );
+    h.srcSize = key.size; h.srcMtime = key.mtime; h.srcHash = key.hash;
+    h.nodes = s.nodeCount(); h.tris = s.triCount(); h.quads = s.quadCount(); h.edges = s.edgeCount();
+    h.skipped = s.stats.skippedElements;
+    h.minX = s.minX; h.minY = s.minY; h.maxX = s.maxX; h.maxY = s.maxY;
+    const Layout l = layoutOf( h );
+
+    const fs::path dst = pathFor( mesh );
+    fs::path tmp = dst;
+    tmp += ".tmp";
+    {
+        std::ofstream out( tmp, std::ios::binary | std::ios::trunc );
+        if ( !out ) return false;
+        size_t at = 0;
+        auto put = [&]( size_t offset, const void* data, size_t bytes )
+            {
+                static const char zeros[8] = {};
+                out.write( zeros, std::streamsize( offset - at ) );    // alignment padding
+                out.write( static_cast<const char*>(data), std::streamsize( bytes ) );
+                at = offset + bytes;
+            };
+        put( 0, &h, sizeof( h ) );
+        put( l.x, s.x.data(), s.x.size() * sizeof( double ) );
+        put( l.y, s.y.data(), s.y.size() * sizeof( double ) );
+        put( l.ids, s.ids.data(), s.ids.size() * sizeof( uint32_t ) );
+        put( l.tris, s.tris.data(), s.tris.size() * sizeof( uint32_t ) );
+        put( l.quads, s.quads.data(), s.quads.size() * sizeof( uint32_t ) );
+        put( l.edges, s.edges.data(), s.edges.size() * sizeof( uint32_t ) );
+        put( l.total, nullptr, 0 );
+        if ( !out ) { out.close(); std::error_code ec; fs::remove( tmp, ec ); return false; }
+    }
+    std::error_code ec;
+    fs::rename( tmp, dst, ec );
+    if ( ec ) fs::remove( tmp, ec );
+    return !ec;
+}
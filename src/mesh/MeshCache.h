@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+
+#include "MeshSnapshot.h"
+
+// Binary sidecar cache ("<name>.mesh.qmvc") holding the snapshot arrays, so a
+// large mesh reopens with one mapped read instead of a text parse plus the
+// pointer-graph extraction. Keyed on the source's size, mtime and a sampled
+// content hash; a stale, truncated or foreign file is simply ignored.
+namespace MeshCache
+{
+	struct Key
+	{
+		uint64_t size = 0;
+		int64_t mtime = 0;
+		uint64_t hash = 0;
+	};
+
+	std::filesystem::path pathFor( const std::filesystem::path& mesh );
+
+	// false if the source cannot be stat'ed/mapped
+	bool keyOf( const std::filesystem::path& mesh, Key& key );
+
+	// header-only check
+	bool fresh( const std::filesystem::path& mesh, const Key& key );
+
+	// nullptr on a miss, or when a section or node index does not fit
+	std::shared_ptr<MeshSnapshot> load( const std::filesystem::path& mesh, const Key& key );
+
+	// writes to a temp file and renames it over the old cache
+	bool store( const std::filesystem::path& mesh, const Key& key, const MeshSnapshot& s );
+}
@@ -0,0 +1,577 @@
+// MeshChunks.cpp
+#include "MeshChunks.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <unordered_map>
+
+namespace
+{
+    // sort fixed-size tuples and drop repeats
+    void uniqueTuples( std::vector<uint32_t>& a, size_t n )
+    {
+        const size_t count = a.size() / n;
+        std::vector<uint32_t> order( count );
+        for ( size_t i = 0; i < count; ++i ) order[i] = uint32_t( i );
+        auto less = [&]( uint32_t x, uint32_t y )
+            {
+                return std::lexicographical_compare( &a[x * n], &a[x * n + n], &a[y * n], &a[y * n + n] );
+            };
+        std::sort( order.begin(), order.end(), less );
+        std::vector<uint32_t> out;
+        out.reserve( a.size() );
+        for ( size_t i = 0; i < count; ++i )
+        {
+            const uint32_t* t = &a[size_t( order[i] ) * n];
+            if ( i && std::equal( t, t + n, &a[size_t( order[i - 1] ) * n] ) ) continue;
+            out.insert( out.end(), t, t + n );
+        }
+        a.swap( out );
+    }
+
+    // sort (a, b, flags) edge triples and merge repeats, OR-ing their flags
+    void uniqueEdges( std::vector<uint32_t>& a )
+    {
+        const size_t count = a.size() / 3;
+        std::vector<uint64_t> keyed( count );
+        for ( size_t i = 0; i < count; ++i ) keyed[i] = (uint64_t( a[i * 3] ) << 32) | a[i * 3 + 1];
+        std::vector<uint32_t> order( count );
+        for ( size_t i = 0; i < count; ++i ) order[i] = uint32_t( i );
+        std::sort( order.begin(), order.end(), [&]( uint32_t x, uint32_t y ) { return keyed[x] < keyed[y]; } );
+        std::vector<uint32_t> out;
+        out.reserve( a.size() );
+        for ( size_t i = 0; i < count; ++i )
+        {
+            const uint32_t* t = &a[size_t( order[i] ) * 3];
+            if ( i && keyed[order[i]] == keyed[order[i - 1]] ) { out.back() |= t[2]; continue; }
+            out.insert( out.end(), t, t + 3 );
+        }
+        a.swap( out );
+    }
+
+    uint64_t sideKey( uint32_t a, uint32_t b ) { return (uint64_t( std::min( a, b ) ) << 32) | std::max( a, b ); }
+
+    // spread the low 16 bits of v to the even bit positions
+    uint32_t part1By1( uint32_t v )
+    {
+        v &= 0x0000FFFF;
+        v = (v | (v << 8)) & 0x00FF00FF;
+        v = (v | (v << 4)) & 0x0F0F0F0F;
+        v = (v | (v << 2)) & 0x33333333;
+        v = (v | (v << 1)) & 0x55555555;
+        return v;
+    }
+
+    // Tipsify (Sander, Nehab, Barczak 2007): fans around the most recently
+    // cached vertex that will still be in the cache, falling back to recent
+    // dead-end vertices. Returns the new order of the n triangles.
+    std::vector<uint32_t> tipsify( const uint32_t* tris, size_t n, size_t cache )
+    {
+        std::vector<uint32_t> verts( tris, tris + n * 3 );
+        std::sort( verts.begin(), verts.end() );
+        verts.erase( std::unique( verts.begin(), verts.end() ), verts.end() );
+        const size_t nv = verts.size();
+        std::vector<uint32_t> local( n * 3 );
+        for ( size_t i = 0; i < n * 3; ++i )
+            local[i] = uint32_t( std::lower_bound( verts.begin(), verts.end(), tris[i] ) - verts.begin() );
+
+        // vertex -> triangles
+        std::vector<uint32_t> start( nv + 1, 0 ), adj( n * 3 );
+        for ( uint32_t v : local ) ++start[v + 1];
+        for ( size_t v = 0; v < nv; ++v ) start[v + 1] += start[v];
+        std::vector<uint32_t> live( nv ), fill( start.begin(), start.end() - 1 );
+        for ( size_t i = 0; i < n * 3; ++i ) adj[fill[local[i]]++] = uint32_t( i / 3 );
+        for ( size_t v = 0; v < nv; ++v ) live[v] = start[v + 1] - start[v];
+
+        std::vector<size_t> stamp( nv, 0 );
+        std::vector<char> emitted( n, 0 );
+        std::vector<uint32_t> deadEnd, candidates, out;
+        out.reserve( n );
+        size_t time = cache + 1, cursor = 0;
+        auto nextLive = [&]() -> int64_t
+            {
+                while ( !deadEnd.empty() )
+                {
+                    const uint32_t d = deadEnd.back();
+                    deadEnd.pop_back();
+                    if ( live[d] ) return d;
+                }
+                for ( ; cursor < nv; ++cursor )
+                    if ( live[cursor] ) return int64_t( cursor );
+                return -1;
+            };
+
+        int64_t f = nextLive();
+        while ( f >= 0 )
+        {
+            candidates.clear();
+            for ( uint32_t k = start[f]; k < start[f + 1]; ++k )
+            {
+                const uint32_t t = adj[k];
+                if ( emitted[t] ) continue;
+                emitted[t] = 1;
+                out.push_back( t );
+                for ( int j = 0; j < 3; ++j )
+                {
+                    const uint32_t v = local[t * 3 + j];
+                    deadEnd.push_back( v );
+                    candidates.push_back( v );
+                    --live[v];
+                    if ( time - stamp[v] > cache ) stamp[v] = time++;
+                }
+            }
+
+            // best candidate: still has triangles and stays cached while they are emitted
+            f = -1;
+            size_t best = 0;
+            for ( uint32_t v : candidates )
+            {
+                if ( !live[v] ) continue;
+                const size_t age = time - stamp[v];
+                const size_t priority = age + 2 * live[v] <= cache ? age : 0;
+                if ( f < 0 || priority > best ) { f = v; best = priority; }
+            }
+            if ( f < 0 ) f = nextLive();
+        }
+        return out;
+    }
+}
+
+void MeshChunks::build( const MeshSnapshot& s )
+{
+    *this = {};
+    const size_t ne = s.elementCount(), nEdges = s.edgeCount();
+    if ( ne == 0 && nEdges == 0 ) return;
+
+    const double w = std::max( s.maxX - s.minX, 1e-9 ), h = std::max( s.maxY - s.minY, 1e-9 );
+    const double cells = std::max<double>( 1.0, double( s.primitiveCount() ) / kTargetTris );
+    const int gx = std::max( 1, int( std::lround( std::sqrt( cells * w / h ) ) ) );
+    const int gy = std::max( 1, int( std::ceil( cells / gx ) ) );
+    const size_t nCells = size_t( gx ) * gy;
+    auto cellOf = [&]( double x, double y )
+        {
+            const int cx = std::clamp( int( (x - s.minX) / w * gx ), 0, gx - 1 );
+            const int cy = std::clamp( int( (y - s.minY) / h * gy ), 0, gy - 1 );
+            return uint32_t( size_t( cy ) * gx + cx );
+        };
+
+    // --- bin elements by centroid and edges by midpoint ---
+    const size_t nt = s.triCount();
+    std::vector<uint32_t> elemCell( ne ), edgeCell( nEdges );
+    parallelFor( ne, [&]( size_t b, size_t e, size_t )
+                 {
+                     for ( size_t i = b; i < e; ++i )
+                     {
+                         const uint32_t* c = i < nt ? &s.tris[i * 3] : &s.quads[(i - nt) * 4];
+                         const int n = i < nt ? 3 : 4;
+                         double x = 0, y = 0;
+                         for ( int k = 0; k < n; ++k ) { x += s.x[c[k]]; y += s.y[c[k]]; }
+                         elemCell[i] = cellOf( x / n, y / n );
+                     }
+                 } );
+    parallelFor( nEdges, [&]( size_t b, size_t e, size_t )
+                 {
+                     for ( size_t i = b; i < e; ++i )
+                     {
+                         const uint32_t a = s.edges[i * 2], c = s.edges[i * 2 + 1];
+                         edgeCell[i] = cellOf( 0.5 * (s.x[a] + s.x[c]), 0.5 * (s.y[a] + s.y[c]) );
+                     }
+                 } );
+
+    // --- counting sort, stable, so primitives keep their order inside a cell ---
+    std::vector<uint32_t> triStart( nCells + 1, 0 ), edgeStart( nCells + 1, 0 );
+    for ( size_t i = 0; i < ne; ++i ) triStart[elemCell[i] + 1] += i < nt ? 1 : 2;
+    for ( size_t i = 0; i < nEdges; ++i ) ++edgeStart[edgeCell[i] + 1];
+    for ( size_t c = 0; c < nCells; ++c )
+    {
+        triStart[c + 1] += triStart[c];
+        edgeStart[c + 1] += edgeStart[c];
+    }
+
+    const size_t np = s.primitiveCount();
+    const auto tri = s.triangulated();
+    indices.resize( np * 3 );
+    primOfGpu.resize( np );
+    gpuOfPrim.resize( np );
+    edges.resize( nEdges * 2 );
+
+    Chunk empty{};
+    empty.minX = empty.minY = FLT_MAX;
+    empty.maxX = empty.maxY = -FLT_MAX;
+    std::vector<Chunk> cellBox( nCells, empty );
+    auto grow = [&]( Chunk& c, uint32_t v )
+        {
+            const float x = float( s.x[v] ), y = float( s.y[v] );
+            c.minX = std::min( c.minX, x ); c.maxX = std::max( c.maxX, x );
+            c.minY = std::min( c.minY, y ); c.maxY = std::max( c.maxY, y );
+        };
+
+    std::vector<uint32_t> triAt( triStart.begin(), triStart.end() - 1 );
+    for ( size_t i = 0; i < ne; ++i )
+    {
+        uint32_t first, count;
+        s.primitivesOfElement( uint32_t( i ), first, count );
+        Chunk& box = cellBox[elemCell[i]];
+        for ( uint32_t p = first; p < first + count; ++p )
+        {
+            const uint32_t g = triAt[elemCell[i]]++;
+            primOfGpu[g] = p;
+            gpuOfPrim[p] = g;
+            for ( int k = 0; k < 3; ++k )
+            {
+                indices[size_t( g ) * 3 + k] = tri[size_t( p ) * 3 + k];
+                grow( box, tri[size_t( p ) * 3 + k] );
+            }
+        }
+    }
+
+    // --- classify edges: a side of fewer than two elements is boundary ---
+    std::vector<uint64_t> sides;
+    sides.reserve( s.tris.size() + s.quads.size() );
+    for ( size_t t = 0; t < s.tris.size(); t += 3 )
+        for ( int k = 0; k < 3; ++k ) sides.push_back( sideKey( s.tris[t + k], s.tris[t + (k + 1) % 3] ) );
+    for ( size_t q = 0; q < s.quads.size(); q += 4 )
+        for ( int k = 0; k < 4; ++k ) sides.push_back( sideKey( s.quads[q + k], s.quads[q + (k + 1) % 4] ) );
+    std::sort( sides.begin(), sides.end() );
+    edgeFlags.resize( nEdges );
+
+    std::vector<uint32_t> edgeAt( edgeStart.begin(), edgeStart.end() - 1 );
+    for ( size_t i = 0; i < nEdges; ++i )
+    {
+        const uint32_t g = edgeAt[edgeCell[i]]++;
+        edges[size_t( g ) * 2] = s.edges[i * 2];
+        edges[size_t( g ) * 2 + 1] = s.edges[i * 2 + 1];
+        const auto run = std::equal_range( sides.begin(), sides.end(), sideKey( s.edges[i * 2], s.edges[i * 2 + 1] ) );
+        uint8_t f = uint8_t( run.second - run.first > 1 ? EdgeClass::Interior : EdgeClass::Boundary );
+        if ( !s.frontEdges.empty() && s.frontEdges[i] ) f |= uint8_t( EdgeClass::Front );
+        edgeFlags[g] = f;
+        grow( cellBox[edgeCell[i]], s.edges[i * 2] );
+        grow( cellBox[edgeCell[i]], s.edges[i * 2 + 1] );
+    }
+
+    // --- non-empty cells become chunks ---
+    for ( size_t c = 0; c < nCells; ++c )
+    {
+        Chunk ch = cellBox[c];
+        ch.firstTri = triStart[c];
+        ch.triCount = triStart[c + 1] - triStart[c];
+        ch.firstEdge = edgeStart[c];
+        ch.edgeCount = edgeStart[c + 1] - edgeStart[c];
+        if ( ch.triCount || ch.edgeCount ) chunks.push_back( ch );
+    }
+
+    buildLevels( s );
+}
+
+void MeshChunks::buildLevels( const MeshSnapshot& s )
+{
+    // vertices used by more than one chunk are pinned
+    constexpr uint32_t kNone = UINT32_MAX, kShared = UINT32_MAX - 1;
+    std::vector<uint32_t> owner( s.nodeCount(), kNone );
+    auto claim = [&]( uint32_t v, uint32_t c ) { owner[v] = owner[v] == kNone || owner[v] == c ? c : kShared; };
+    for ( uint32_t c = 0; c < chunks.size(); ++c )
+    {
+        const Chunk& ch = chunks[c];
+        for ( size_t i = size_t( ch.firstTri ) * 3; i < size_t( ch.firstTri + ch.triCount ) * 3; ++i ) claim( indices[i], c );
+        for ( size_t i = size_t( ch.firstEdge ) * 2; i < size_t( ch.firstEdge + ch.edgeCount ) * 2; ++i ) claim( edges[i], c );
+    }
+
+    struct Out
+    {
+        std::vector<uint32_t> tris, edges;
+        std::vector<uint8_t> edgeFlags;
+        std::vector<Level> levels;          // ranges relative to tris/edges above
+    };
+    std::vector<Out> out( chunks.size() );
+
+    parallelFor( chunks.size(), [&]( size_t b, size_t e, size_t )
+                 {
+                     std::vector<uint32_t> verts, rep, lt, le;
+                     std::unordered_map<uint64_t, uint32_t> cellRep;
+                     for ( size_t c = b; c < e; ++c )
+                     {
+                         const Chunk& ch = chunks[c];
+                         const uint32_t* ti = &indices[size_t( ch.firstTri ) * 3];
+                         const uint32_t* ei = &edges[size_t( ch.firstEdge ) * 2];
+                         verts.assign( ti, ti + size_t( ch.triCount ) * 3 );
+                         verts.insert( verts.end(), ei, ei + size_t( ch.edgeCount ) * 2 );
+                         std::sort( verts.begin(), verts.end() );
+                         verts.erase( std::unique( verts.begin(), verts.end() ), verts.end() );
+                         auto local = [&]( uint32_t v ) { return size_t( std::lower_bound( verts.begin(), verts.end(), v ) - verts.begin() ); };
+
+                         const double extent = std::max( double( ch.maxX - ch.minX ), double( ch.maxY - ch.minY ) );
+                         int res = 1;
+                         while ( size_t( res ) * res * 4 < verts.size() ) res *= 2;
+
+                         size_t prevTris = ch.triCount, prevEdges = ch.edgeCount;
+                         rep.resize( verts.size() );
+                         for ( ; res >= 2 && extent > 0; res /= 2 )
+                         {
+                             const double cell = extent / res;
+                             cellRep.clear();
+                             for ( size_t i = 0; i < verts.size(); ++i )
+                             {
+                                 const uint32_t v = verts[i];
+                                 if ( owner[v] == kShared ) { rep[i] = v; continue; }
+                                 const uint64_t cx = uint64_t( std::min<double>( (s.x[v] - ch.minX) / cell, res - 1 ) );
+                                 const uint64_t cy = uint64_t( std::min<double>( (s.y[v] - ch.minY) / cell, res - 1 ) );
+                                 rep[i] = cellRep.try_emplace( (cy << 32) | cx, v ).first->second;
+                             }
+
+                             lt.clear();
+                             for ( uint32_t t = 0; t < ch.triCount; ++t )
+                             {
+                                 uint32_t a = rep[local( ti[t * 3] )], bb = rep[local( ti[t * 3 + 1] )], cc = rep[local( ti[t * 3 + 2] )];
+                                 if ( a == bb || bb == cc || a == cc ) continue;
+                                 // rotate the smallest first (keeps winding) so duplicates compare equal
+                                 while ( a > bb || a > cc ) { const uint32_t tmp = a; a = bb; bb = cc; cc = tmp; }
+                                 lt.insert( lt.end(), { a, bb, cc } );
+                             }
+                             le.clear();
+                             for ( uint32_t k = 0; k < ch.edgeCount; ++k )
+                             {
+                                 const uint32_t a = rep[local( ei[k * 2] )], bb = rep[local( ei[k * 2 + 1] )];
+                                 if ( a != bb ) le.insert( le.end(), { std::min( a, bb ), std::max( a, bb ), edgeFlags[ch.firstEdge + k] } );
+                             }
+                             uniqueTuples( lt, 3 );
+                             uniqueEdges( le );
+
+                             // stop once a level no longer pays for itself
+                             const size_t nt = lt.size() / 3, ne = le.size() / 3;
+                             if ( nt + ne > 0.9 * double( prevTris + prevEdges ) ) continue;
+                             Out& o = out[c];
+                             Level lv{};
+                             lv.firstTri = uint32_t( o.tris.size() / 3 );
+                             lv.triCount = uint32_t( nt );
+                             lv.firstEdge = uint32_t( o.edges.size() / 2 );
+                             lv.edgeCount = uint32_t( ne );
+                             lv.error = float( cell * 1.41421356 );
+                             o.levels.push_back( lv );
+                             o.tris.insert( o.tris.end(), lt.begin(), lt.end() );
+                             for ( size_t k = 0; k < ne; ++k )
+                             {
+                                 o.edges.insert( o.edges.end(), { le[k * 3], le[k * 3 + 1] } );
+                                 o.edgeFlags.push_back( uint8_t( le[k * 3 + 2] ) );
+                             }
+                             prevTris = nt; prevEdges = ne;
+                         }
+                     }
+                 }, 1 );
+
+    // append after the exact primitives, rebasing the ranges
+    for ( size_t c = 0; c < chunks.size(); ++c )
+    {
+        Out& o = out[c];
+        const uint32_t triBase = uint32_t( indices.size() / 3 ), edgeBase = uint32_t( edges.size() / 2 );
+        chunks[c].firstLevel = uint32_t( levels.size() );
+        chunks[c].levelCount = uint32_t( o.levels.size() );
+        for ( Level lv : o.levels )
+        {
+            lv.firstTri += triBase;
+            lv.firstEdge += edgeBase;
+            levels.push_back( lv );
+        }
+        indices.insert( indices.end(), o.tris.begin(), o.tris.end() );
+        edges.insert( edges.end(), o.edges.begin(), o.edges.end() );
+        edgeFlags.insert( edgeFlags.end(), o.edgeFlags.begin(), o.edgeFlags.end() );
+        o = {};
+    }
+}
+
+void MeshChunks::localize( const MeshSnapshot& s )
+{
+    if ( localized || chunks.empty() ) return;
+
+    // per chunk: the vertices its ranges use, exact and LOD, their box and their quantized copies
+    std::vector<std::vector<uint32_t>> verts( chunks.size() );
+    struct Box { double minX, minY, maxX, maxY; };
+    std::vector<Box> boxes( chunks.size() );
+    parallelFor( chunks.size(), [&]( size_t b, size_t e, size_t )
+                 {
+                     for ( size_t c = b; c < e; ++c )
+                     {
+                         Chunk& ch = chunks[c];
+                         std::vector<Range> ranges{ ch };
+                         for ( uint32_t l = 0; l < ch.levelCount; ++l ) ranges.push_back( levels[ch.firstLevel + l] );
+
+                         auto& v = verts[c];
+                         for ( const Range& r : ranges )
+                         {
+                             v.insert( v.end(), &indices[size_t( r.firstTri ) * 3], &indices[size_t( r.firstTri + r.triCount ) * 3] );
+                             v.insert( v.end(), &edges[size_t( r.firstEdge ) * 2], &edges[size_t( r.firstEdge + r.edgeCount ) * 2] );
+                         }
+                         std::sort( v.begin(), v.end() );
+                         v.erase( std::unique( v.begin(), v.end() ), v.end() );
+
+                         auto local = [&]( uint32_t& i ) { i = uint32_t( std::lower_bound( v.begin(), v.end(), i ) - v.begin() ); };
+                         for ( const Range& r : ranges )
+                         {
+                             std::for_each( &indices[size_t( r.firstTri ) * 3], &indices[size_t( r.firstTri + r.triCount ) * 3], local );
+                             std::for_each( &edges[size_t( r.firstEdge ) * 2], &edges[size_t( r.firstEdge + r.edgeCount ) * 2], local );
+                         }
+
+                         Box& box = boxes[c];
+                         box = { DBL_MAX, DBL_MAX, -DBL_MAX, -DBL_MAX };
+                         for ( uint32_t i : v )
+                         {
+                             const uint32_t n = nodeOf( i );
+                             box.minX = std::min( box.minX, s.x[n] ); box.maxX = std::max( box.maxX, s.x[n] );
+                             box.minY = std::min( box.minY, s.y[n] ); box.maxY = std::max( box.maxY, s.y[n] );
+                         }
+                     }
+                 }, 1 );
+
+    // One lattice for the whole mesh. The step is a power of two just coarse
+    // enough for the widest chunk to fit in 16 bits (with a step to spare for
+    // rounding) and for every cell index to fit comfortably in an int32.
+    double minX = DBL_MAX, minY = DBL_MAX, maxX = -DBL_MAX, maxY = -DBL_MAX, widest = 0.0;
+    for ( const Box& b : boxes )
+    {
+        if ( b.minX > b.maxX ) continue;         // no vertices
+        minX = std::min( minX, b.minX ); maxX = std::max( maxX, b.maxX );
+        minY = std::min( minY, b.minY ); maxY = std::max( maxY, b.maxY );
+        widest = std::max( { widest, b.maxX - b.minX, b.maxY - b.minY } );
+    }
+    if ( minX > maxX ) minX = minY = maxX = maxY = 0.0;
+    const double want = std::max( widest / 65533.0, std::max( maxX - minX, maxY - minY ) / double( 1 << 30 ) );
+    latticeStep = want > 0.0 ? std::exp2( std::ceil( std::log2( want ) ) ) : 1.0;
+    latticeX = std::floor( minX / latticeStep ) * latticeStep;
+    latticeY = std::floor( minY / latticeStep ) * latticeStep;
+    // the lattice point nearest to v; the same for a vertex whichever chunk holds it
+    auto pointX = [&]( double v ) { return int32_t( std::llround( (v - latticeX) / latticeStep ) ); };
+    auto pointY = [&]( double v ) { return int32_t( std::llround( (v - latticeY) / latticeStep ) ); };
+    for ( size_t c = 0; c < chunks.size(); ++c )
+    {
+        const bool empty = verts[c].empty();
+        chunks[c].cellX = empty ? 0 : pointX( boxes[c].minX );
+        chunks[c].cellY = empty ? 0 : pointY( boxes[c].minY );
+    }
+
+    size_t total = 0;
+    for ( size_t c = 0; c < chunks.size(); ++c )
+    {
+        chunks[c].firstVertex = uint32_t( total );
+        total += verts[c].size();
+    }
+    quantized.resize( total * 2 );
+    parallelFor( chunks.size(), [&]( size_t b, size_t e, size_t )
+                 {
+                     for ( size_t c = b; c < e; ++c )
+                     {
+                         const Chunk& ch = chunks[c];
+                         uint16_t* q = &quantized[size_t( ch.firstVertex ) * 2];
+                         for ( uint32_t v : verts[c] )
+                         {
+                             const uint32_t n = nodeOf( v );
+                             *q++ = uint16_t( pointX( s.x[n] ) - ch.cellX );
+                             *q++ = uint16_t( pointY( s.y[n] ) - ch.cellY );
+                         }
+                     }
+                 }, 1 );
+    localized = true;
+}
+
+double MeshChunks::acmr( const uint32_t* idx, size_t triCount, size_t cacheSize )
+{
+    if ( !triCount ) return 0.0;
+    std::vector<uint32_t> fifo( cacheSize, UINT32_MAX );
+    size_t head = 0, misses = 0;
+    for ( size_t i = 0; i < triCount * 3; ++i )
+    {
+        if ( std::find( fifo.begin(), fifo.end(), idx[i] ) != fifo.end() ) continue;
+        fifo[head] = idx[i];
+        head = (head + 1) % cacheSize;
+        ++misses;
+    }
+    return double( misses ) / double( triCount );
+}
+
+void MeshChunks::reorder( const MeshSnapshot& s )
+{
+    if ( reordered() || localized || chunks.empty() ) return;
+    const auto t0 = std::chrono::steady_clock::now();
+    const size_t exactTris = primOfGpu.size();
+    order.acmrBefore = acmr( indices.data(), exactTris );
+
+    // --- vertices along a Morton curve over the mesh box ---
+    const size_t nn = s.nodeCount();
+    const double w = std::max( s.maxX - s.minX, 1e-30 ), h = std::max( s.maxY - s.minY, 1e-30 );
+    std::vector<uint64_t> keyed( nn );
+    parallelFor( nn, [&]( size_t b, size_t e, size_t )
+                 {
+                     for ( size_t i = b; i < e; ++i )
+                     {
+                         const uint32_t qx = uint32_t( std::clamp( (s.x[i] - s.minX) / w, 0.0, 1.0 ) * 65535.0 );
+                         const uint32_t qy = uint32_t( std::clamp( (s.y[i] - s.minY) / h, 0.0, 1.0 ) * 65535.0 );
+                         keyed[i] = (uint64_t( part1By1( qx ) | (part1By1( qy ) << 1) ) << 32) | i;
+                     }
+                 } );
+    std::sort( keyed.begin(), keyed.end() );
+    nodeOfVertex.resize( nn );
+    std::vector<uint32_t> vertexOfNode( nn );
+    for ( size_t v = 0; v < nn; ++v )
+    {
+        nodeOfVertex[v] = uint32_t( keyed[v] );
+        vertexOfNode[nodeOfVertex[v]] = uint32_t( v );
+    }
+    keyed = {};
+    auto renumber = [&]( std::vector<uint32_t>& a )
+        {
+            parallelFor( a.size(), [&]( size_t b, size_t e, size_t )
+                         {
+                             for ( size_t i = b; i < e; ++i ) a[i] = vertexOfNode[a[i]];
+                         } );
+        };
+    renumber( indices );
+    renumber( edges );
+
+    // --- triangles: Tipsify per range; exact ranges keep elements whole ---
+    parallelFor( chunks.size(), [&]( size_t b, size_t e, size_t )
+                 {
+                     std::vector<uint32_t> tris, prims;
+                     std::vector<char> done;
+                     for ( size_t c = b; c < e; ++c )
+                     {
+                         const Chunk& ch = chunks[c];
+                         for ( uint32_t l = 0; l < ch.levelCount; ++l )
+                         {
+                             const Level& lv = levels[ch.firstLevel + l];
+                             uint32_t* ti = &indices[size_t( lv.firstTri ) * 3];
+                             const auto ord = tipsify( ti, lv.triCount, kVertexCache );
+                             tris.assign( ti, ti + size_t( lv.triCount ) * 3 );
+                             for ( size_t k = 0; k < ord.size(); ++k )
+                                 std::copy_n( &tris[size_t( ord[k] ) * 3], 3, &ti[k * 3] );
+                         }
+
+                         if ( !ch.triCount ) continue;
+                         uint32_t* ti = &indices[size_t( ch.firstTri ) * 3];
+                         const auto ord = tipsify( ti, ch.triCount, kVertexCache );
+                         tris.assign( ti, ti + size_t( ch.triCount ) * 3 );
+                         prims.assign( &primOfGpu[ch.firstTri], &primOfGpu[ch.firstTri] + ch.triCount );
+                         done.assign( ch.triCount, 0 );
+                         uint32_t g = ch.firstTri;
+                         for ( uint32_t t : ord )
+                         {
+                             if ( done[t] ) continue;
+                             uint32_t first, count;
+                             s.primitivesOfElement( s.elementOfPrimitive( prims[t] ), first, count );
+                             // the element's triangles sit together in the old chunk order
+                             const uint32_t old = gpuOfPrim[first] - ch.firstTri;
+                             for ( uint32_t k = 0; k < count; ++k )
+                             {
+                                 done[old + k] = 1;
+                                 std::copy_n( &tris[size_t( old + k ) * 3], 3, &ti[size_t( g - ch.firstTri ) * 3] );
+                                 primOfGpu[g] = prims[old + k];
+                                 ++g;
+                             }
+                         }
+                         for ( uint32_t k = ch.firstTri; k < g; ++k ) gpuOfPrim[primOfGpu[k]] = k;
+                     }
+                 }, 1 );
+
+    order.acmrAfter = acmr( indices.data(), exactTris );
+    order.ms = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - t0 ).count();
+}
@@ -0,0 +1,128 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "MeshSnapshot.h"
+
+// Spatial partition of a snapshot for culled drawing: a uniform grid sized
+// for ~kTargetTris triangles per cell; each non-empty cell becomes a chunk
+// with a contiguous range of triangles and edges in the GPU buffers. Elements
+// are binned by centroid, so a quad's two triangles stay adjacent.
+//
+// Each chunk also gets coarser levels of detail by vertex clustering: a grid
+// over the chunk snaps every vertex to one representative vertex of its cell,
+// and triangles/edges that collapse are dropped. Vertices shared with another
+// chunk are never moved, so neighbouring chunks at different levels still
+// meet without cracks. LOD primitives reference existing vertices only and
+// are appended after the exact ones in the same index/segment buffers.
+//
+// reorder() optionally renumbers the GPU vertices along a Morton curve and
+// reorders each chunk's triangles for post-transform vertex cache reuse
+// (Tipsify); elements are emitted whole, so the adjacency above still holds.
+// GPU vertex ids then differ from snapshot node indices (nodeOf()).
+//
+// localize() optionally turns this into the compact vertex layout: every chunk
+// gets its own copy of the vertices it uses, stored as two unorm16 steps from
+// the chunk's cell, and its indices become chunk-local (drawn with baseVertex).
+// All chunks share one lattice (a power-of-two step from one mesh origin), so
+// a vertex on a chunk border decodes to the same lattice point, bit for bit,
+// from either side.
+//
+// Every GPU edge carries EdgeClass flags in edgeFlags, classified once at
+// build time; an LOD edge gets the union of the edges it stands in for, so a
+// category filter never hides a coarse edge that still represents one shown.
+enum class EdgeClass : uint8_t
+{
+	Interior = 1,       // shared by two elements
+	Boundary = 2,       // side of at most one element
+	Front = 4,          // on the QMorph front (live meshes only)
+	All = 7
+};
+
+struct MeshChunks
+{
+	static constexpr size_t kTargetTris = 4096;
+
+	struct Range
+	{
+		uint32_t firstTri, triCount;    // GPU triangle range
+		uint32_t firstEdge, edgeCount;  // GPU edge range
+	};
+
+	struct Chunk : Range
+	{
+		float minX, minY, maxX, maxY;   // covers its triangles and edges
+		uint32_t firstLevel, levelCount;   // into levels, finest first
+		uint32_t firstVertex;           // baseVertex; 0 unless localized
+		int32_t cellX, cellY;           // lattice point of unorm16 (0, 0), when localized
+	};
+
+	struct Level : Range
+	{
+		float error;                    // max vertex displacement, world units
+	};
+
+	std::vector<Chunk> chunks;
+	std::vector<Level> levels;
+	std::vector<uint32_t> indices;      // 3 per triangle: exact ones chunk by chunk, then LODs
+	std::vector<uint32_t> edges;        // 2 per edge, same layout
+	std::vector<uint8_t> edgeFlags;     // EdgeClass bits per GPU edge, same layout
+	std::vector<uint32_t> primOfGpu;    // exact GPU triangle -> snapshot primitive
+	std::vector<uint32_t> gpuOfPrim;    // snapshot primitive -> exact GPU triangle
+	std::vector<uint16_t> quantized;    // 2 per vertex, chunk by chunk (localized only)
+	std::vector<uint32_t> nodeOfVertex; // GPU vertex -> snapshot node (reordered only)
+	bool localized = false;
+	// localized: world = lattice + (cell + q) * latticeStep, q the unorm16 pair
+	double latticeX = 0.0, latticeY = 0.0, latticeStep = 0.0;
+
+	// vertices shaded per triangle of the exact ranges, FIFO cache of kVertexCache
+	static constexpr size_t kVertexCache = 16;
+	struct OrderStats { double acmrBefore = 0, acmrAfter = 0, ms = 0; };
+	OrderStats order;
+
+	void build( const MeshSnapshot& s );
+	void reorder( const MeshSnapshot& s );      // after build(), before localize()
+	void localize( const MeshSnapshot& s );
+
+	uint32_t nodeOf( uint32_t v ) const { return nodeOfVertex.empty() ? v : nodeOfVertex[v]; }
+	bool reordered() const { return !nodeOfVertex.empty(); }
+	static double acmr( const uint32_t* idx, size_t triCount, size_t cacheSize = kVertexCache );
+
+	// chunk holding exact GPU triangle g
+	uint32_t chunkOfTri( uint32_t g ) const
+	{
+		auto it = std::upper_bound( chunks.begin(), chunks.end(), g,
+									[]( uint32_t t, const Chunk& c ) { return t < c.firstTri; } );
+		return uint32_t( it - chunks.begin() ) - 1;
+	}
+
+	// Coarsest range of chunk c whose error stays under maxErrorPx at the
+	// given zoom (pixels per world unit); the exact range when none does
+	const Range& select( const Chunk& c, float pixelsPerUnit, float maxErrorPx ) const
+	{
+		return range( c, selectSlot( c, pixelsPerUnit, maxErrorPx ) );
+	}
+
+	// same choice as a slot: 0 for the exact range, l + 1 for level l
+	uint32_t selectSlot( const Chunk& c, float pixelsPerUnit, float maxErrorPx ) const
+	{
+		uint32_t slot = 0;
+		for ( uint32_t l = 0; l < c.levelCount; ++l )
+		{
+			if ( levels[c.firstLevel + l].error * pixelsPerUnit > maxErrorPx ) break;
+			slot = l + 1;
+		}
+		return slot;
+	}
+
+	const Range& range( const Chunk& c, uint32_t slot ) const
+	{
+		if ( slot ) return levels[c.firstLevel + slot - 1];
+		return c;
+	}
+
+private:
+	void buildLevels( const MeshSnapshot& s );
+};
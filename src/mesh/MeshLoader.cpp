@@ -0,0 +1,117 @@
+// MeshLoader.cpp
+#include "MeshLoader.h"
+#include "MeshCache.h"
+#include "MeshText.h"
+#include "Trace.h"
+
+#include <GeomBasics.h>
+
+#include <chrono>
+#include <exception>
+
+namespace fs = std::filesystem;
+
+bool MeshLoader::loadGeometry( const fs::path& path, MeshSnapshot::Stats* timings, const Checkpoint& checkpoint )
+{
+    auto proceed = [&]( const char* phase ) { return !checkpoint || checkpoint( phase ); };
+
+    if ( !proceed( "Parsing" ) ) return false;
+    MeshText::Parsed parsed;
+    if ( MeshText::parse( path, parsed ) )
+    {
+        if ( !proceed( "Building geometry" ) ) return false;
+        const double constructMs = MeshText::construct( path, parsed );
+        if ( timings )
+        {
+            timings->ioMs = parsed.stats.ioMs;
+            timings->parseMs = parsed.stats.parseMs;
+            timings->dedupeMs = parsed.stats.dedupeMs;
+            timings->constructMs = constructMs;
+        }
+        return true;
+    }
+
+    if ( !proceed( "Reading mesh" ) ) return false;
+    const auto t0 = std::chrono::steady_clock::now();
+    GeomBasics::clearLists();
+    GeomBasics::setParams( path.filename().string(), path.parent_path().string(), false, false );
+    {
+        Trace::Scope trace( "GeomBasics::loadMesh" );
+        GeomBasics::loadMesh();
+    }
+    {
+        Trace::Scope trace( "GeomBasics::findExtremeNodes" );
+        GeomBasics::findExtremeNodes();
+    }
+    if ( timings )
+        timings->constructMs = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - t0 ).count();
+    return true;
+}
+
+MeshLoader::Result MeshLoader::load( const fs::path& path, bool useCache, const Checkpoint& checkpoint )
+{
+    Trace::Scope trace( "LoadMesh" );
+    Result r;
+    if ( checkpoint && !checkpoint( "Checking cache" ) ) { r.cancelled = true; return r; }
+    MeshCache::Key key;
+    const bool keyed = useCache && MeshCache::keyOf( path, key );
+    if ( keyed )
+        r.snapshot = MeshCache::load( path, key );
+    if ( r.snapshot ) return r;
+
+    MeshSnapshot::Stats timings;
+    std::shared_ptr<MeshSnapshot> snap;
+    try
+    {
+        if ( !loadGeometry( path, &timings, checkpoint ) ) { r.cancelled = true; return r; }
+        r.geometryLoaded = true;
+        if ( checkpoint ) checkpoint( "Extracting" );   // past the point of no return
+        snap = MeshSnapshot::extract();
+    }
+    catch ( const std::exception& e )
+    {
+        // the lists may be half rebuilt; empty is the only consistent state left
+        GeomBasics::clearLists();
+        r.geometryLoaded = true;
+        r.error = e.what();
+        return r;
+    }
+    snap->stats.ioMs = timings.ioMs;
+    snap->stats.parseMs = timings.parseMs;
+    snap->stats.dedupeMs = timings.dedupeMs;
+    snap->stats.constructMs = timings.constructMs;
+    if ( keyed ) MeshCache::store( path, key, *snap );
+    r.snapshot = std::move( snap );
+    return r;
+}
+
+size_t MeshLoader::buildCaches( const fs::path& dir,
+                                const std::function<void( const fs::path&, bool )>& report )
+{
+    size_t built = 0;
+    std::error_code ec;
+    for ( fs::recursive_directory_iterator it( dir, ec ), end; !ec && it != end; it.increment( ec ) )
+    {
+        if ( !it->is_regular_file() || it->path().extension() != ".mesh" ) continue;
+        const fs::path& p = it->path();
+        MeshCache::Key key;
+        bool ok = MeshCache::keyOf( p, key );
+        if ( ok && !MeshCache::fresh( p, key ) )
+        {
+            // one bad file is a FAIL line, not the end of the run
+            try
+            {
+                ok = loadGeometry( p ) && MeshCache::store( p, key, *MeshSnapshot::extract() );
+            }
+            catch ( const std::exception& )
+            {
+                GeomBasics::clearLists();
+                ok = false;
+            }
+            built += ok;
+        }
+        if ( report ) report( p, ok );
+    }
+    GeomBasics::clearLists();
+    return built;
+}
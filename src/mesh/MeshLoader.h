@@ -0,0 +1,41 @@
+#pragma once
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "MeshSnapshot.h"
+
+// Opening a .mesh file: either straight from the binary sidecar cache, or the
+// text path through GeomBasics followed by a snapshot extraction.
+namespace MeshLoader
+{
+	// Called between phases with a short description; return false to stop.
+	// Once GeomBasics starts being rebuilt the load runs to the end, so a
+	// cancelled load never leaves the lists half replaced.
+	using Checkpoint = std::function<bool( const std::string& phase )>;
+
+	struct Result
+	{
+		std::shared_ptr<const MeshSnapshot> snapshot;
+		bool geometryLoaded = false;    // false on a cache hit: GeomBasics untouched
+		bool cancelled = false;         // snapshot is null, GeomBasics untouched
+		// set when the text path failed after GeomBasics was cleared; the
+		// lists are then left empty and snapshot is null (geometryLoaded is true)
+		std::string error;
+	};
+
+	// Text .mesh -> GeomBasics lists (clears them first). Uses the parallel
+	// MeshText reader, or GeomBasics::loadMesh() for files it rejects; the
+	// load timings go into 'timings' when given. False when cancelled.
+	bool loadGeometry( const std::filesystem::path& path, MeshSnapshot::Stats* timings = nullptr,
+					   const Checkpoint& checkpoint = {} );
+
+	// On a cache miss the text is parsed and, if useCache, the cache rewritten
+	Result load( const std::filesystem::path& path, bool useCache, const Checkpoint& checkpoint = {} );
+
+	// Builds missing/stale caches for every .mesh under dir; returns how many
+	// were written. report( file, ok ) is called once per mesh found.
+	size_t buildCaches( const std::filesystem::path& dir,
+						const std::function<void( const std::filesystem::path&, bool )>& report );
+}
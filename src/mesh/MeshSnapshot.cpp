@@ -0,0 +1,285 @@
+// MeshSnapshot.cpp
+#include "MeshSnapshot.h"
+#include "Parallel.h"
+#include "Trace.h"
+
+#include <GeomBasics.h>
+
+#include <algorithm>
+#include <chrono>
+#include <unordered_map>
+
+namespace
+{
+    // node number -> dense index; a flat table when the numbering is
+    // reasonably compact, a hash map when it is very sparse
+    class NodeRemap
+    {
+    public:
+        NodeRemap( uint32_t maxNumber, size_t count )
+        {
+            sparse_ = size_t( maxNumber ) > 4 * count + 1024;
+            if ( sparse_ ) map_.reserve( count );
+            else table_.assign( size_t( maxNumber ) + 1, UINT32_MAX );
+        }
+        void set( uint32_t number, uint32_t dense )
+        {
+            if ( sparse_ ) map_[number] = dense;
+            else table_[number] = dense;
+        }
+        bool sparse() const { return sparse_; }
+        uint32_t operator()( uint32_t number ) const
+        {
+            if ( !sparse_ ) return number < table_.size() ? table_[number] : UINT32_MAX;
+            auto it = map_.find( number );
+            return it == map_.end() ? UINT32_MAX : it->second;
+        }
+    private:
+        bool sparse_ = false;
+        std::vector<uint32_t> table_;
+        std::unordered_map<uint32_t, uint32_t> map_;
+    };
+
+    template<class NodePtr>
+    uint32_t numberOf( const NodePtr& n ) { return uint32_t( n->GetNumber() ); }
+
+    // raw pointers into a GeomBasics list, for random access from workers
+    template<class List>
+    auto gather( const List& list )
+    {
+        std::vector<decltype(&**list.begin())> out;
+        out.reserve( list.size() );
+        for ( const auto& p : list ) out.push_back( &*p );
+        return out;
+    }
+
+    // exclusive prefix sum over per-chunk counts; returns the total
+    size_t prefixSum( std::vector<size_t>& v )
+    {
+        size_t sum = 0;
+        for ( auto& c : v ) { const size_t n = c; c = sum; sum += n; }
+        return sum;
+    }
+
+    // drop entries containing UINT32_MAX (unresolved corners); rare, so sequential
+    size_t compact( std::vector<uint32_t>& a, size_t stride )
+    {
+        size_t out = 0, dropped = 0;
+        for ( size_t i = 0; i < a.size(); i += stride )
+        {
+            if ( std::find( a.begin() + i, a.begin() + i + stride, UINT32_MAX ) != a.begin() + i + stride )
+            {
+                ++dropped;
+                continue;
+            }
+            if ( out != i ) std::copy( a.begin() + i, a.begin() + i + stride, a.begin() + out );
+            out += stride;
+        }
+        a.resize( out );
+        return dropped;
+    }
+
+    double msSince( std::chrono::steady_clock::time_point& t )
+    {
+        const auto now = std::chrono::steady_clock::now();
+        const double ms = std::chrono::duration<double, std::milli>( now - t ).count();
+        t = now;
+        return ms;
+    }
+}
+
+size_t MeshSnapshot::bytes() const
+{
+    return (x.capacity() + y.capacity()) * sizeof( double )
+        + (ids.capacity() + tris.capacity() + quads.capacity() + edges.capacity()) * sizeof( uint32_t )
+        + frontEdges.capacity();
+}
+
+std::vector<float> MeshSnapshot::positions() const
+{
+    std::vector<float> p( nodeCount() * 3 );
+    for ( size_t i = 0; i < nodeCount(); ++i )
+    {
+        p[i * 3 + 0] = float( x[i] );
+        p[i * 3 + 1] = float( y[i] );
+        p[i * 3 + 2] = 0.0f;
+    }
+    return p;
+}
+
+std::vector<uint32_t> MeshSnapshot::triangulated() const
+{
+    std::vector<uint32_t> idx;
+    idx.reserve( primitiveCount() * 3 );
+    idx.insert( idx.end(), tris.begin(), tris.end() );
+    for ( size_t q = 0; q < quads.size(); q += 4 )
+    {
+        const uint32_t* c = &quads[q];
+        idx.insert( idx.end(), { c[0], c[1], c[2], c[0], c[2], c[3] } );
+    }
+    return idx;
+}
+
+std::shared_ptr<MeshSnapshot> MeshSnapshot::extract()
+{
+    Trace::Scope trace( "MeshSnapshot::extract" );
+    using clock = std::chrono::steady_clock;
+    const auto t0 = clock::now();
+    auto tp = t0;
+
+    auto snap = std::make_shared<MeshSnapshot>();
+    auto& s = *snap;
+    auto& st = s.stats;
+    st.threads = workerCount();
+
+    // --- gather: the lists are walked once, sequentially, into pointer arrays ---
+    const auto nodes = gather( GeomBasics::nodeList );
+    const auto triList = gather( GeomBasics::triangleList );
+    const auto elemList = gather( GeomBasics::elementList );
+    const auto edgeList = gather( GeomBasics::edgeList );
+    st.gatherMs = msSince( tp );
+
+    // --- nodes: positions, dense ids, remap table ---
+    const size_t nn = nodes.size();
+    std::vector<uint32_t> maxPart( parallelChunkCount( nn ), 0 );
+    parallelFor( nn, [&]( size_t b, size_t e, size_t c )
+                 {
+                     uint32_t m = 0;
+                     for ( size_t i = b; i < e; ++i ) m = std::max( m, numberOf( nodes[i] ) );
+                     maxPart[c] = m;
+                 } );
+    const uint32_t maxNumber = maxPart.empty() ? 0 : *std::max_element( maxPart.begin(), maxPart.end() );
+
+    NodeRemap remap( maxNumber, nn );
+    s.x.resize( nn ); s.y.resize( nn ); s.ids.resize( nn );
+    parallelFor( nn, [&]( size_t b, size_t e, size_t )
+                 {
+                     for ( size_t i = b; i < e; ++i )
+                     {
+                         s.x[i] = nodes[i]->x;
+                         s.y[i] = nodes[i]->y;
+                         s.ids[i] = numberOf( nodes[i] );
+                         if ( !remap.sparse() ) remap.set( s.ids[i], uint32_t( i ) ); // distinct slots
+                     }
+                 } );
+    if ( remap.sparse() )
+        for ( size_t i = 0; i < nn; ++i ) remap.set( s.ids[i], uint32_t( i ) );
+    st.nodesMs = msSince( tp );
+
+    // three corners from two adjacent edges
+    auto triCorners = [&]( const Edge& e1, const Edge& e2, uint32_t* out )
+        {
+            out[0] = remap( numberOf( e1.leftNode ) );
+            out[1] = remap( numberOf( e1.rightNode ) );
+            if ( !e2.leftNode->equals( e1.leftNode ) && !e2.leftNode->equals( e1.rightNode ) )
+                out[2] = remap( numberOf( e2.leftNode ) );
+            else
+                out[2] = remap( numberOf( e2.rightNode ) );
+        };
+
+    // walk the four edges so the corners come out in cyclic order
+    auto quadCorners = [&]( const auto& edges, uint32_t* out )
+        {
+            uint32_t a[4], b[4];
+            for ( int i = 0; i < 4; ++i )
+            {
+                a[i] = remap( numberOf( edges[i]->leftNode ) );
+                b[i] = remap( numberOf( edges[i]->rightNode ) );
+            }
+            bool used[4] = { true, false, false, false };
+            out[0] = a[0]; out[1] = b[0];
+            for ( int k = 2; k < 4; ++k )
+            {
+                const uint32_t prev = out[k - 1];
+                int next = -1;
+                for ( int i = 1; i < 4 && next < 0; ++i )
+                    if ( !used[i] && (a[i] == prev || b[i] == prev) ) next = i;
+                if ( next < 0 ) { out[k] = UINT32_MAX; continue; }
+                used[next] = true;
+                out[k] = a[next] == prev ? b[next] : a[next];
+            }
+        };
+
+    // --- elements: count per chunk, prefix sum, then emit at precomputed offsets ---
+    const size_t nt = triList.size(), ne = elemList.size();
+    const size_t chunks = parallelChunkCount( ne );
+    std::vector<size_t> triOff( chunks, 0 ), quadOff( chunks, 0 );
+    parallelFor( ne, [&]( size_t b, size_t e, size_t c )
+                 {
+                     for ( size_t i = b; i < e; ++i )
+                         (elemList[i]->edgeList.size() == 4 ? quadOff[c] : triOff[c])++;
+                 } );
+    const size_t elemTris = prefixSum( triOff );
+    const size_t quads = prefixSum( quadOff );
+
+    s.tris.resize( (nt + elemTris) * 3 );
+    s.quads.resize( quads * 4 );
+    parallelFor( nt, [&]( size_t b, size_t e, size_t )
+                 {
+                     for ( size_t i = b; i < e; ++i )
+                         triCorners( *triList[i]->edgeList[0], *triList[i]->edgeList[1], &s.tris[i * 3] );
+                 } );
+    parallelFor( ne, [&]( size_t b, size_t e, size_t c )
+                 {
+                     size_t t = nt + triOff[c], q = quadOff[c];
+                     for ( size_t i = b; i < e; ++i )
+                     {
+                         const auto& el = *elemList[i];
+                         if ( el.edgeList.size() == 4 )
+                             quadCorners( el.edgeList, &s.quads[q++ * 4] );
+                         else
+                             triCorners( *el.edgeList[0], *el.edgeList[1], &s.tris[t++ * 3] );
+                     }
+                 } );
+    st.skippedElements = compact( s.tris, 3 ) + compact( s.quads, 4 );
+    st.elementsMs = msSince( tp );
+
+    // --- edges; the front flag rides along as a third column until compacted ---
+    std::vector<uint32_t> edges3( edgeList.size() * 3 );
+    parallelFor( edgeList.size(), [&]( size_t b, size_t e, size_t )
+                 {
+                     for ( size_t i = b; i < e; ++i )
+                     {
+                         edges3[i * 3] = remap( numberOf( edgeList[i]->leftNode ) );
+                         edges3[i * 3 + 1] = remap( numberOf( edgeList[i]->rightNode ) );
+                         // QMorph marks its front on the edges
+                         edges3[i * 3 + 2] = edgeList[i]->frontEdge ? 1u : 0u;
+                     }
+                 } );
+    compact( edges3, 3 );
+    s.edges.resize( edges3.size() / 3 * 2 );
+    s.frontEdges.resize( edges3.size() / 3 );
+    bool anyFront = false;
+    for ( size_t i = 0; i < s.frontEdges.size(); ++i )
+    {
+        s.edges[i * 2] = edges3[i * 3];
+        s.edges[i * 2 + 1] = edges3[i * 3 + 1];
+        s.frontEdges[i] = uint8_t( edges3[i * 3 + 2] );
+        anyFront |= s.frontEdges[i] != 0;
+    }
+    if ( !anyFront ) s.frontEdges = {};
+    st.edgesMs = msSince( tp );
+
+    // --- bbox: per-chunk min/max, then a tiny serial reduce ---
+    struct Box { double x0 = DBL_MAX, y0 = DBL_MAX, x1 = -DBL_MAX, y1 = -DBL_MAX; };
+    std::vector<Box> part( parallelChunkCount( nn ) );
+    parallelFor( nn, [&]( size_t b, size_t e, size_t c )
+                 {
+                     Box bb;
+                     for ( size_t i = b; i < e; ++i )
+                     {
+                         bb.x0 = std::min( bb.x0, s.x[i] ); bb.x1 = std::max( bb.x1, s.x[i] );
+                         bb.y0 = std::min( bb.y0, s.y[i] ); bb.y1 = std::max( bb.y1, s.y[i] );
+                     }
+                     part[c] = bb;
+                 } );
+    for ( const auto& bb : part )
+    {
+        s.minX = std::min( s.minX, bb.x0 ); s.maxX = std::max( s.maxX, bb.x1 );
+        s.minY = std::min( s.minY, bb.y0 ); s.maxY = std::max( s.maxY, bb.y1 );
+    }
+    st.bboxMs = msSince( tp );
+
+    st.extractMs = std::chrono::duration<double, std::milli>( clock::now() - t0 ).count();
+    return snap;
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <cfloat>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Compact structure-of-arrays copy of the mesh, extracted from the GeomBasics
+// pointer graph in one linear pass per list. Nodes are renumbered densely
+// (0..n-1); ids maps back to the GeomBasics node number. Immutable once
+// built, so it can be handed from a worker thread to the UI and is the one
+// source for rendering, picking, labels and statistics.
+//
+// Element ids: triangles first (0..triCount-1), then quads. On the GPU each
+// quad is drawn as two consecutive triangles after all the triangles.
+struct MeshSnapshot
+{
+	// nodes
+	std::vector<double> x, y;
+	std::vector<uint32_t> ids;          // dense index -> node number
+
+	// connectivity, dense node indices
+	std::vector<uint32_t> tris;         // 3 per triangle
+	std::vector<uint32_t> quads;        // 4 per quad, in cyclic order
+	std::vector<uint32_t> edges;        // 2 per GeomBasics edge
+	std::vector<uint8_t> frontEdges;    // 1 per edge on the QMorph front; empty unless extracted live
+
+	double minX = DBL_MAX, minY = DBL_MAX, maxX = -DBL_MAX, maxY = -DBL_MAX;
+
+	struct Stats
+	{
+		double extractMs = 0;           // total
+		double gatherMs = 0, nodesMs = 0, elementsMs = 0, edgesMs = 0, bboxMs = 0;
+		unsigned threads = 1;
+		size_t skippedElements = 0;     // elements whose corners could not be resolved
+		bool fromCache = false;         // read from the sidecar cache, not extracted
+		double cacheMs = 0;
+		// text load that preceded the extraction, if any (see MeshText)
+		double ioMs = 0, parseMs = 0, dedupeMs = 0, constructMs = 0;
+	} stats;
+
+	size_t nodeCount() const { return ids.size(); }
+	size_t triCount() const { return tris.size() / 3; }
+	size_t quadCount() const { return quads.size() / 4; }
+	size_t elementCount() const { return triCount() + quadCount(); }
+	size_t edgeCount() const { return edges.size() / 2; }
+	size_t primitiveCount() const { return triCount() + 2 * quadCount(); }
+	size_t bytes() const;
+
+	// GPU-facing views
+	std::vector<float> positions() const;           // xyz per node, z = 0
+	std::vector<uint32_t> triangulated() const;     // tris, then two per quad
+
+	// GPU primitive <-> element id
+	uint32_t elementOfPrimitive( uint32_t prim ) const
+	{
+		const uint32_t nt = uint32_t( triCount() );
+		return prim < nt ? prim : nt + (prim - nt) / 2;
+	}
+	void primitivesOfElement( uint32_t elem, uint32_t& first, uint32_t& count ) const
+	{
+		const uint32_t nt = uint32_t( triCount() );
+		if ( elem < nt ) { first = elem; count = 1; }
+		else { first = nt + 2 * (elem - nt); count = 2; }
+	}
+
+	// Reads GeomBasics; the caller must own the lists for the duration
+	static std::shared_ptr<MeshSnapshot> extract();
+};
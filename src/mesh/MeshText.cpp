@@ -0,0 +1,331 @@
+// MeshText.cpp
+#include "MeshText.h"
+#include "MappedFile.h"
+#include "Parallel.h"
+#include "Trace.h"
+
+#include <GeomBasics.h>
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <unordered_map>
+
+namespace
+{
+    double msSince( std::chrono::steady_clock::time_point& t )
+    {
+        const auto now = std::chrono::steady_clock::now();
+        const double ms = std::chrono::duration<double, std::milli>( now - t ).count();
+        t = now;
+        return ms;
+    }
+
+    size_t prefixSum( std::vector<size_t>& v )
+    {
+        size_t sum = 0;
+        for ( auto& c : v ) { const size_t n = c; c = sum; sum += n; }
+        return sum;
+    }
+
+    uint64_t mix64( uint64_t h )
+    {
+        h ^= h >> 33; h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33; h *= 0xc4ceb9fe1a85ec53ull;
+        return h ^ (h >> 33);
+    }
+
+    // -0.0 and 0.0 are the same node, as with Node::equals
+    uint64_t bitsOf( double v )
+    {
+        v += 0.0;
+        uint64_t b;
+        std::memcpy( &b, &v, sizeof( b ) );
+        return b;
+    }
+
+    struct PointKey
+    {
+        uint64_t x, y;
+        bool operator==( const PointKey& o ) const { return x == o.x && y == o.y; }
+    };
+    struct PointHash { size_t operator()( const PointKey& k ) const { return size_t( mix64( k.x ^ mix64( k.y ) ) ); } };
+    struct EdgeHash { size_t operator()( uint64_t k ) const { return size_t( mix64( k ) ); } };
+
+    // Gives each of n items the id of its key, ids numbered by first
+    // occurrence. Items are bucketed into hash shards (count, prefix sum,
+    // scatter), each shard is deduplicated by one worker, and the shard-local
+    // ids are then renumbered in item order. Returns the first item of each id.
+    template<class Key, class Hash, class KeyOf>
+    std::vector<uint32_t> dedupe( size_t n, KeyOf keyOf, std::vector<uint32_t>& idOf )
+    {
+        const size_t shards = size_t( workerCount() ) * 4;
+        std::vector<uint16_t> shardOf( n );
+        const size_t chunks = parallelChunkCount( n );
+        std::vector<size_t> counts( chunks * shards, 0 );
+        parallelFor( n, [&]( size_t b, size_t e, size_t c )
+                     {
+                         size_t* cnt = &counts[c * shards];
+                         for ( size_t i = b; i < e; ++i )
+                         {
+                             shardOf[i] = uint16_t( Hash{}(keyOf( i )) % shards );
+                             ++cnt[shardOf[i]];
+                         }
+                     } );
+
+        // shard-major offsets so every shard is contiguous and in item order
+        std::vector<size_t> offs( chunks * shards );
+        std::vector<size_t> shardBegin( shards + 1, 0 );
+        size_t at = 0;
+        for ( size_t s = 0; s < shards; ++s )
+        {
+            shardBegin[s] = at;
+            for ( size_t c = 0; c < chunks; ++c ) { offs[c * shards + s] = at; at += counts[c * shards + s]; }
+        }
+        shardBegin[shards] = at;
+
+        std::vector<uint32_t> order( n );
+        parallelFor( n, [&]( size_t b, size_t e, size_t c )
+                     {
+                         size_t* o = &offs[c * shards];
+                         for ( size_t i = b; i < e; ++i ) order[o[shardOf[i]]++] = uint32_t( i );
+                     } );
+
+        idOf.resize( n );
+        std::vector<std::vector<uint32_t>> firsts( shards );
+        parallelFor( shards, [&]( size_t b, size_t e, size_t )
+                     {
+                         for ( size_t s = b; s < e; ++s )
+                         {
+                             std::unordered_map<Key, uint32_t, Hash> seen;
+                             seen.reserve( shardBegin[s + 1] - shardBegin[s] );
+                             for ( size_t k = shardBegin[s]; k < shardBegin[s + 1]; ++k )
+                             {
+                                 const uint32_t i = order[k];
+                                 auto [it, added] = seen.try_emplace( keyOf( i ), uint32_t( firsts[s].size() ) );
+                                 if ( added ) firsts[s].push_back( i );
+                                 idOf[i] = it->second;
+                             }
+                         }
+                     }, 1 );
+
+        // shard-local -> global ids in order of first occurrence
+        std::vector<size_t> localBase( shards + 1, 0 );
+        for ( size_t s = 0; s < shards; ++s ) localBase[s + 1] = localBase[s] + firsts[s].size();
+        std::vector<uint32_t> unique;
+        unique.reserve( localBase[shards] );
+        for ( auto& f : firsts ) unique.insert( unique.end(), f.begin(), f.end() );
+        std::sort( unique.begin(), unique.end() );
+
+        std::vector<uint32_t> global( unique.size() );
+        for ( size_t r = 0; r < unique.size(); ++r )
+        {
+            const uint32_t f = unique[r];
+            global[localBase[shardOf[f]] + idOf[f]] = uint32_t( r );
+        }
+        parallelFor( n, [&]( size_t b, size_t e, size_t )
+                     {
+                         for ( size_t i = b; i < e; ++i ) idOf[i] = global[localBase[shardOf[i]] + idOf[i]];
+                     } );
+        return unique;
+    }
+
+    // edges of an element, as corner slot pairs, in GeomBasics::loadMesh() order
+    constexpr int kTriEdges[3][2] = { { 0, 1 }, { 1, 2 }, { 0, 2 } };
+    constexpr int kQuadEdges[4][2] = { { 0, 1 }, { 0, 3 }, { 1, 2 }, { 3, 2 } };   // base, left, right, top
+
+    struct Chunk
+    {
+        std::vector<double> xy;         // corner coordinates
+        std::vector<uint8_t> arity;     // 3 or 4 per element
+        size_t bad = 0;
+    };
+
+    // lines that start in [b, e); the last one may run past e
+    void parseChunk( const char* data, size_t size, size_t b, size_t e, Chunk& out )
+    {
+        size_t s = b;
+        while ( s > 0 && s < size && data[s - 1] != '\n' ) ++s;
+        out.xy.reserve( (e - b) / 4 );
+        out.arity.reserve( (e - b) / 48 );
+
+        const char* p = data + s;
+        const char* const stop = data + std::min( e, size );
+        const char* const end = data + size;
+        while ( p < stop )
+        {
+            const char* eol = static_cast<const char*>(std::memchr( p, '\n', size_t( end - p ) ));
+            if ( !eol ) eol = end;
+
+            double v[8];
+            int k = 0;
+            for ( const char* q = p;; )
+            {
+                while ( q < eol && (*q == ' ' || *q == '\t' || *q == ',' || *q == '\r') ) ++q;
+                if ( q == eol ) break;
+                if ( k == 8 ) { k = -1; break; }
+                const auto r = std::from_chars( q, eol, v[k] );
+                if ( r.ec != std::errc() ) { k = -1; break; }
+                ++k;
+                q = r.ptr;
+            }
+            if ( k == 6 || k == 8 )
+            {
+                out.xy.insert( out.xy.end(), v, v + k );
+                out.arity.push_back( uint8_t( k / 2 ) );
+            }
+            else if ( k != 0 )
+                ++out.bad;
+            p = eol + 1;
+        }
+    }
+}
+
+bool MeshText::parse( const std::filesystem::path& path, Parsed& out )
+{
+    Trace::Scope trace( "MeshText::parse" );
+    using clock = std::chrono::steady_clock;
+    auto tp = clock::now();
+    out = {};
+    auto& st = out.stats;
+    st.threads = workerCount();
+
+    MappedFile f( path );
+    if ( !f.isOpen() ) return false;
+    const char* data = reinterpret_cast<const char*>(f.data());
+    const size_t size = f.size();
+    st.ioMs = msSince( tp );
+
+    // --- parse: chunk per worker, split at line starts ---
+    constexpr size_t kMinChunk = 1 << 20;
+    std::vector<Chunk> chunks( std::max<size_t>( 1, parallelChunkCount( size, kMinChunk ) ) );
+    parallelFor( size, [&]( size_t b, size_t e, size_t c ) { parseChunk( data, size, b, e, chunks[c] ); }, kMinChunk );
+
+    std::vector<size_t> cornerBase( chunks.size() ), elemBase( chunks.size() );
+    for ( size_t c = 0; c < chunks.size(); ++c )
+    {
+        if ( chunks[c].bad ) return false;
+        cornerBase[c] = chunks[c].xy.size() / 2;
+        elemBase[c] = chunks[c].arity.size();
+    }
+    const size_t nc = prefixSum( cornerBase );
+    const size_t ne = prefixSum( elemBase );
+    if ( nc >= UINT32_MAX ) return false;
+
+    std::vector<double> xy( nc * 2 );
+    out.elemFirst.resize( ne + 1 );
+    out.elemFirst[ne] = nc;
+    parallelFor( chunks.size(), [&]( size_t b, size_t e, size_t )
+                 {
+                     for ( size_t c = b; c < e; ++c )
+                     {
+                         std::copy( chunks[c].xy.begin(), chunks[c].xy.end(), xy.begin() + cornerBase[c] * 2 );
+                         size_t at = cornerBase[c];
+                         for ( size_t i = 0; i < chunks[c].arity.size(); ++i )
+                         {
+                             out.elemFirst[elemBase[c] + i] = at;
+                             at += chunks[c].arity[i];
+                         }
+                         chunks[c] = {};
+                     }
+                 }, 1 );
+    st.parseMs = msSince( tp );
+
+    // --- nodes: merge equal coordinates ---
+    const auto nodeFirst = dedupe<PointKey, PointHash>( nc, [&]( size_t i )
+                                                        { return PointKey{ bitsOf( xy[i * 2] ), bitsOf( xy[i * 2 + 1] ) }; },
+                                                        out.corners );
+    out.x.resize( nodeFirst.size() );
+    out.y.resize( nodeFirst.size() );
+    parallelFor( nodeFirst.size(), [&]( size_t b, size_t e, size_t )
+                 {
+                     for ( size_t i = b; i < e; ++i )
+                     {
+                         out.x[i] = xy[size_t( nodeFirst[i] ) * 2];
+                         out.y[i] = xy[size_t( nodeFirst[i] ) * 2 + 1];
+                     }
+                 } );
+    xy = {};
+
+    // --- edges: merge equal node pairs regardless of direction ---
+    std::vector<uint64_t> pairs( nc );
+    parallelFor( ne, [&]( size_t b, size_t e, size_t )
+                 {
+                     for ( size_t el = b; el < e; ++el )
+                     {
+                         const size_t o = out.elemFirst[el];
+                         const bool quad = out.arity( el ) == 4;
+                         for ( size_t j = 0; j < out.arity( el ); ++j )
+                         {
+                             const int* s = quad ? kQuadEdges[j] : kTriEdges[j];
+                             pairs[o + j] = (uint64_t( out.corners[o + s[0]] ) << 32) | out.corners[o + s[1]];
+                         }
+                     }
+                 } );
+    auto undirected = [&]( size_t i )
+        {
+            const uint64_t a = pairs[i] >> 32, b = pairs[i] & 0xFFFFFFFFu;
+            return a < b ? (a << 32) | b : (b << 32) | a;
+        };
+    const auto edgeFirst = dedupe<uint64_t, EdgeHash>( nc, undirected, out.cornerEdges );
+    out.edges.resize( edgeFirst.size() * 2 );
+    for ( size_t i = 0; i < edgeFirst.size(); ++i )
+    {
+        out.edges[i * 2] = uint32_t( pairs[edgeFirst[i]] >> 32 );
+        out.edges[i * 2 + 1] = uint32_t( pairs[edgeFirst[i]] );
+    }
+    st.dedupeMs = msSince( tp );
+    return true;
+}
+
+double MeshText::construct( const std::filesystem::path& path, const Parsed& in )
+{
+    // object graph wiring is inherently serial; the win here is skipping the
+    // per-line list searches and growing each list exactly once
+    Trace::Scope trace( "MeshText::construct" );
+    auto tp = std::chrono::steady_clock::now();
+    GeomBasics::clearLists();
+    GeomBasics::setParams( path.filename().string(), path.parent_path().string(), false, false );
+
+    auto& nodes = GeomBasics::nodeList;
+    nodes.reserve( in.x.size() );
+    for ( size_t i = 0; i < in.x.size(); ++i )
+        nodes.push_back( std::make_shared<Node>( in.x[i], in.y[i] ) );
+
+    auto& edges = GeomBasics::edgeList;
+    edges.reserve( in.edges.size() / 2 );
+    for ( size_t i = 0; i < in.edges.size(); i += 2 )
+    {
+        auto e = std::make_shared<Edge>( nodes[in.edges[i]], nodes[in.edges[i + 1]] );
+        e->leftNode->connectTo( e );
+        e->rightNode->connectTo( e );
+        edges.push_back( std::move( e ) );
+    }
+
+    size_t nq = 0;
+    for ( size_t el = 0; el < in.elementCount(); ++el ) nq += in.arity( el ) == 4;
+    GeomBasics::triangleList.reserve( in.elementCount() - nq );
+    GeomBasics::elementList.reserve( nq );
+    for ( size_t el = 0; el < in.elementCount(); ++el )
+    {
+        const uint32_t* ce = &in.cornerEdges[in.elemFirst[el]];
+        if ( in.arity( el ) == 3 )
+        {
+            auto t = std::make_shared<Triangle>( edges[ce[0]], edges[ce[1]], edges[ce[2]] );
+            for ( int j = 0; j < 3; ++j ) edges[ce[j]]->connectToTriangle( t );
+            GeomBasics::triangleList.push_back( std::move( t ) );
+        }
+        else
+        {
+            auto q = std::make_shared<Quad>( edges[ce[0]], edges[ce[1]], edges[ce[2]], edges[ce[3]] );
+            for ( int j = 0; j < 4; ++j ) edges[ce[j]]->connectToQuad( q );
+            GeomBasics::elementList.push_back( std::move( q ) );
+        }
+    }
+    {
+        Trace::Scope traceExtreme( "GeomBasics::findExtremeNodes" );
+        GeomBasics::findExtremeNodes();
+    }
+    return msSince( tp );
+}
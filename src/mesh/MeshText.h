@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+// Parallel reader for the text .mesh format: one element per line, given by
+// its corner coordinates ("x1, y1, x2, y2, x3, y3" for a triangle, eight
+// numbers for a quad). The file is mapped, split at line boundaries and
+// parsed with std::from_chars on all cores; equal coordinates and equal node
+// pairs are merged into nodes and edges in order of first appearance, which
+// is what GeomBasics::loadMesh() does one list lookup at a time.
+namespace MeshText
+{
+	struct Parsed
+	{
+		std::vector<double> x, y;           // unique nodes
+		std::vector<uint32_t> corners;      // node per corner, 3 or 4 per element, file order
+		std::vector<uint32_t> cornerEdges;  // edge per corner slot (same layout as corners)
+		std::vector<size_t> elemFirst;      // element -> first corner, plus an end sentinel
+		std::vector<uint32_t> edges;        // 2 nodes per unique edge
+
+		struct Stats
+		{
+			double ioMs = 0, parseMs = 0, dedupeMs = 0;
+			unsigned threads = 1;
+		} stats;
+
+		size_t elementCount() const { return elemFirst.empty() ? 0 : elemFirst.size() - 1; }
+		size_t arity( size_t e ) const { return elemFirst[e + 1] - elemFirst[e]; }
+	};
+
+	// false if the file cannot be mapped or has lines that are not 6 or 8
+	// numbers; the caller then falls back to GeomBasics::loadMesh()
+	bool parse( const std::filesystem::path& path, Parsed& out );
+
+	// Fills the GeomBasics lists from a parse (clears them first); returns ms
+	double construct( const std::filesystem::path& path, const Parsed& in );
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Number of workers used by the parallel helpers below
+inline unsigned workerCount()
+{
+    const unsigned n = std::thread::hardware_concurrency();
+    return n ? n : 1u;
+}
+
+// Splits [0, n) into contiguous chunks and runs fn( begin, end, chunk ) on each.
+// The calling thread takes the last chunk; small ranges run inline.
+template<class Fn>
+void parallelFor( size_t n, Fn&& fn, size_t minChunk = 4096 )
+{
+    if ( n == 0 ) return;
+    const size_t maxChunks = std::max<size_t>( 1, n / std::max<size_t>( 1, minChunk ) );
+    const size_t chunks = std::min<size_t>( workerCount(), maxChunks );
+    if ( chunks <= 1 )
+    {
+        fn( size_t( 0 ), n, size_t( 0 ) );
+        return;
+    }
+
+    const size_t step = (n + chunks - 1) / chunks;
+    std::vector<std::thread> pool;
+    pool.reserve( chunks - 1 );
+    for ( size_t c = 0; c + 1 < chunks; ++c )
+    {
+        const size_t b = c * step, e = std::min( n, b + step );
+        pool.emplace_back( [&fn, b, e, c] { fn( b, e, c ); } );
+    }
+    const size_t last = chunks - 1;
+    fn( std::min( n, last * step ), n, last );
+    for ( auto& t : pool ) t.join();
+}
+
+// Same chunking as parallelFor, for callers that keep per-chunk partial results
+inline size_t parallelChunkCount( size_t n, size_t minChunk = 4096 )
+{
+    if ( n == 0 ) return 0;
+    const size_t maxChunks = std::max<size_t>( 1, n / std::max<size_t>( 1, minChunk ) );
+    return std::min<size_t>( workerCount(), maxChunks );
+}
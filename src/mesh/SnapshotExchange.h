@@ -0,0 +1,40 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <utility>
+
+struct DisplayData;
+
+// Single-slot handoff between a producer thread and the UI. The producer
+// extracts each snapshot and prepares its display (DisplayData) without any
+// lock and publishes it into the slot under a mutex; the UI takes whatever
+// is there. If the UI falls behind, older ones are simply replaced, never
+// queued.
+class SnapshotExchange
+{
+public:
+	void publish( std::shared_ptr<DisplayData> s )
+	{
+		std::lock_guard lock( m_ );
+		front_ = std::move( s );
+		++published_;
+	}
+
+	// nullptr when nothing new since the last take()
+	std::shared_ptr<DisplayData> take()
+	{
+		std::lock_guard lock( m_ );
+		return std::exchange( front_, nullptr );
+	}
+
+	unsigned published() const
+	{
+		std::lock_guard lock( m_ );
+		return published_;
+	}
+
+private:
+	mutable std::mutex m_;
+	std::shared_ptr<DisplayData> front_;
+	unsigned published_ = 0;
+};
@@ -0,0 +1,254 @@
+// SpatialIndex.cpp
+#include "SpatialIndex.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+
+namespace
+{
+    double segDist2( double x, double y, double ax, double ay, double bx, double by )
+    {
+        const double dx = bx - ax, dy = by - ay;
+        const double len2 = dx * dx + dy * dy;
+        double t = len2 > 0. ? ((x - ax) * dx + (y - ay) * dy) / len2 : 0.;
+        t = std::clamp( t, 0., 1. );
+        const double ex = ax + t * dx - x, ey = ay + t * dy - y;
+        return ex * ex + ey * ey;
+    }
+
+    double cross2( double ax, double ay, double bx, double by, double px, double py )
+    {
+        return (bx - ax) * (py - ay) - (by - ay) * (px - ax);
+    }
+}
+
+void SpatialIndex::clear()
+{
+    snap_.reset();
+    elemCells_ = {}; nodeCells_ = {}; edgeCells_ = {};
+    cellsX_ = cellsY_ = 0;
+    buildMs_ = 0;
+}
+
+int SpatialIndex::cellX( double x ) const
+{
+    return std::clamp( int( (x - minX_) * invCell_ ), 0, cellsX_ - 1 );
+}
+
+int SpatialIndex::cellY( double y ) const
+{
+    return std::clamp( int( (y - minY_) * invCell_ ), 0, cellsY_ - 1 );
+}
+
+const uint32_t* SpatialIndex::corners( uint32_t elem, int& n ) const
+{
+    const size_t nt = snap_->triCount();
+    if ( elem < nt ) { n = 3; return &snap_->tris[size_t( elem ) * 3]; }
+    n = 4;
+    return &snap_->quads[(elem - nt) * 4];
+}
+
+void SpatialIndex::build( std::shared_ptr<const MeshSnapshot> snap )
+{
+    const auto t0 = std::chrono::steady_clock::now();
+    clear();
+    if ( !snap || snap->nodeCount() == 0 || snap->minX > snap->maxX ) return;
+    snap_ = std::move( snap );
+    const MeshSnapshot& s = *snap_;
+
+    const double w = std::max( s.maxX - s.minX, 1e-9 );
+    const double h = std::max( s.maxY - s.minY, 1e-9 );
+
+    // aim for ~2 items per cell
+    const double target = std::clamp<double>( double( std::max( s.elementCount(), s.nodeCount() ) ) / 2.0, 1.0, 4.0e6 );
+    cell_ = std::sqrt( w * h / target );
+    cell_ = std::max( cell_, std::max( w, h ) / 4096.0 );
+    invCell_ = 1.0 / cell_;
+    minX_ = s.minX; minY_ = s.minY;
+    cellsX_ = std::max( 1, int( std::ceil( w * invCell_ ) ) );
+    cellsY_ = std::max( 1, int( std::ceil( h * invCell_ ) ) );
+
+    fill( elemCells_, s.elementCount(), [&]( size_t i, int& cx0, int& cy0, int& cx1, int& cy1 )
+          {
+              int n;
+              const uint32_t* c = corners( uint32_t( i ), n );
+              double x0 = px( c[0] ), x1 = x0, y0 = py( c[0] ), y1 = y0;
+              for ( int k = 1; k < n; ++k )
+              {
+                  x0 = std::min( x0, px( c[k] ) ); x1 = std::max( x1, px( c[k] ) );
+                  y0 = std::min( y0, py( c[k] ) ); y1 = std::max( y1, py( c[k] ) );
+              }
+              cx0 = cellX( x0 ); cx1 = cellX( x1 );
+              cy0 = cellY( y0 ); cy1 = cellY( y1 );
+              return true;
+          } );
+    fill( nodeCells_, s.nodeCount(), [&]( size_t i, int& cx0, int& cy0, int& cx1, int& cy1 )
+          {
+              cx0 = cx1 = cellX( px( uint32_t( i ) ) );
+              cy0 = cy1 = cellY( py( uint32_t( i ) ) );
+              return true;
+          } );
+    fill( edgeCells_, s.edgeCount(), [&]( size_t i, int& cx0, int& cy0, int& cx1, int& cy1 )
+          {
+              const uint32_t a = s.edges[i * 2], b = s.edges[i * 2 + 1];
+              cx0 = cellX( std::min( px( a ), px( b ) ) ); cx1 = cellX( std::max( px( a ), px( b ) ) );
+              cy0 = cellY( std::min( py( a ), py( b ) ) ); cy1 = cellY( std::max( py( a ), py( b ) ) );
+              return true;
+          } );
+
+    buildMs_ = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - t0 ).count();
+}
+
+template<class BoundsFn>
+void SpatialIndex::fill( Buckets& out, size_t count, BoundsFn&& bounds )
+{
+    const size_t cells = size_t( cellsX_ ) * size_t( cellsY_ );
+    std::vector<std::atomic<uint32_t>> cursor( cells );
+
+    // 1) count items per cell
+    parallelFor( count, [&]( size_t b, size_t e, size_t )
+                 {
+                     for ( size_t i = b; i < e; ++i )
+                     {
+                         int cx0, cy0, cx1, cy1;
+                         if ( !bounds( i, cx0, cy0, cx1, cy1 ) ) continue;
+                         for ( int cy = cy0; cy <= cy1; ++cy )
+                             for ( int cx = cx0; cx <= cx1; ++cx )
+                                 cursor[size_t( cy ) * cellsX_ + cx].fetch_add( 1, std::memory_order_relaxed );
+                     }
+                 } );
+
+    // 2) prefix sum, counters become write cursors
+    out.start.assign( cells + 1, 0 );
+    uint32_t sum = 0;
+    for ( size_t c = 0; c < cells; ++c )
+    {
+        out.start[c] = sum;
+        sum += cursor[c].load( std::memory_order_relaxed );
+        cursor[c].store( out.start[c], std::memory_order_relaxed );
+    }
+    out.start[cells] = sum;
+    out.items.resize( sum );
+
+    // 3) scatter
+    parallelFor( count, [&]( size_t b, size_t e, size_t )
+                 {
+                     for ( size_t i = b; i < e; ++i )
+                     {
+                         int cx0, cy0, cx1, cy1;
+                         if ( !bounds( i, cx0, cy0, cx1, cy1 ) ) continue;
+                         for ( int cy = cy0; cy <= cy1; ++cy )
+                             for ( int cx = cx0; cx <= cx1; ++cx )
+                             {
+                                 const uint32_t at = cursor[size_t( cy ) * cellsX_ + cx].fetch_add( 1, std::memory_order_relaxed );
+                                 out.items[at] = uint32_t( i );
+                             }
+                     }
+                 } );
+
+    // scatter order is racy; sort buckets so queries are deterministic
+    parallelFor( cells, [&]( size_t b, size_t e, size_t )
+                 {
+                     for ( size_t c = b; c < e; ++c )
+                         std::sort( out.items.begin() + out.start[c], out.items.begin() + out.start[c + 1] );
+                 } );
+}
+
+int SpatialIndex::findElement( double x, double y ) const
+{
+    if ( empty() ) return -1;
+    if ( x < minX_ || y < minY_ || x > minX_ + cellsX_ * cell_ || y > minY_ + cellsY_ * cell_ ) return -1;
+
+    auto inside = [&]( uint32_t a, uint32_t b, uint32_t d )
+        {
+            const double d0 = cross2( px( a ), py( a ), px( b ), py( b ), x, y );
+            const double d1 = cross2( px( b ), py( b ), px( d ), py( d ), x, y );
+            const double d2 = cross2( px( d ), py( d ), px( a ), py( a ), x, y );
+            const bool hasNeg = d0 < 0 || d1 < 0 || d2 < 0;
+            const bool hasPos = d0 > 0 || d1 > 0 || d2 > 0;
+            return !(hasNeg && hasPos); // either winding
+        };
+
+    const size_t c = size_t( cellY( y ) ) * cellsX_ + cellX( x );
+    for ( uint32_t k = elemCells_.start[c]; k < elemCells_.start[c + 1]; ++k )
+    {
+        const uint32_t e = elemCells_.items[k];
+        int n;
+        const uint32_t* v = corners( e, n );
+        if ( inside( v[0], v[1], v[2] ) || (n == 4 && inside( v[0], v[2], v[3] )) )
+            return int( e );
+    }
+    return -1;
+}
+
+size_t SpatialIndex::countNodesIn( double x0, double y0, double x1, double y1 ) const
+{
+    if ( empty() || x1 < minX_ || y1 < minY_ ) return 0;
+    const int cx0 = cellX( x0 ), cx1 = cellX( x1 ), cy0 = cellY( y0 ), cy1 = cellY( y1 );
+    size_t n = 0;
+    for ( int cy = cy0; cy <= cy1; ++cy )
+    {
+        const size_t row = size_t( cy ) * cellsX_;
+        n += nodeCells_.start[row + cx1 + 1] - nodeCells_.start[row + cx0];
+    }
+    return n;
+}
+
+template<class DistFn>
+int SpatialIndex::nearest( const Buckets& b, double x, double y, double maxDist, DistFn&& dist2 ) const
+{
+    if ( empty() ) return -1;
+    const int qx = cellX( x ), qy = cellY( y );
+    const int maxRing = std::max( cellsX_, cellsY_ );
+
+    int best = -1;
+    double bestD2 = maxDist * maxDist;
+    for ( int r = 0; r <= maxRing; ++r )
+    {
+        // everything not seen yet is at least (r - 1) cells away
+        const double reach = double( r - 1 ) * cell_;
+        if ( r > 0 && reach > 0. && reach * reach > bestD2 ) break;
+
+        for ( int cy = qy - r; cy <= qy + r; ++cy )
+        {
+            if ( cy < 0 || cy >= cellsY_ ) continue;
+            const bool edgeRow = (cy == qy - r || cy == qy + r);
+            for ( int cx = qx - r; cx <= qx + r; cx += (edgeRow || r == 0) ? 1 : 2 * r )
+            {
+                if ( cx < 0 || cx >= cellsX_ ) continue;
+                const size_t c = size_t( cy ) * cellsX_ + cx;
+                for ( uint32_t k = b.start[c]; k < b.start[c + 1]; ++k )
+                {
+                    const uint32_t id = b.items[k];
+                    const double d2 = dist2( id );
+                    if ( d2 < bestD2 || (d2 == bestD2 && best >= 0 && int( id ) < best) )
+                    {
+                        bestD2 = d2; best = int( id );
+                    }
+                }
+            }
+        }
+    }
+    return best;
+}
+
+int SpatialIndex::nearestNode( double x, double y, double maxDist ) const
+{
+    return nearest( nodeCells_, x, y, maxDist, [&]( uint32_t v )
+                    {
+                        const double dx = px( v ) - x, dy = py( v ) - y;
+                        return dx * dx + dy * dy;
+                    } );
+}
+
+int SpatialIndex::nearestEdge( double x, double y, double maxDist ) const
+{
+    return nearest( edgeCells_, x, y, maxDist, [&]( uint32_t e )
+                    {
+                        const uint32_t a = snap_->edges[size_t( e ) * 2], b = snap_->edges[size_t( e ) * 2 + 1];
+                        return segDist2( x, y, px( a ), py( a ), px( b ), py( b ) );
+                    } );
+}
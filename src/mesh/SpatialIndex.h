@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "MeshSnapshot.h"
+
+// Uniform grid over a MeshSnapshot for CPU-side hover/pick queries.
+// Results use the snapshot's ids: element id, dense node index, edge index.
+class SpatialIndex
+{
+public:
+	void build( std::shared_ptr<const MeshSnapshot> snap );
+	void clear();
+	bool empty() const { return cellsX_ == 0; }
+
+	// -1 when nothing qualifies
+	int findElement( double x, double y ) const;
+	int nearestNode( double x, double y, double maxDist ) const;
+	int nearestEdge( double x, double y, double maxDist ) const;
+
+	// Upper bound of the nodes inside a rect, from bucket sizes only
+	size_t countNodesIn( double x0, double y0, double x1, double y1 ) const;
+	// fn( node, x, y ) for every node inside the rect
+	template<class Fn>
+	void forEachNodeIn( double x0, double y0, double x1, double y1, Fn&& fn ) const
+	{
+		if ( empty() || x1 < minX_ || y1 < minY_ ) return;
+		const int cx0 = cellX( x0 ), cx1 = cellX( x1 ), cy0 = cellY( y0 ), cy1 = cellY( y1 );
+		for ( int cy = cy0; cy <= cy1; ++cy )
+			for ( int cx = cx0; cx <= cx1; ++cx )
+			{
+				const size_t c = size_t( cy ) * cellsX_ + cx;
+				for ( uint32_t k = nodeCells_.start[c]; k < nodeCells_.start[c + 1]; ++k )
+				{
+					const uint32_t v = nodeCells_.items[k];
+					const double x = px( v ), y = py( v );
+					if ( x >= x0 && x <= x1 && y >= y0 && y <= y1 )
+						fn( v, x, y );
+				}
+			}
+	}
+
+	double buildMs() const { return buildMs_; }
+
+private:
+	// CSR bucket list: items of cell c are items[start[c] .. start[c+1])
+	struct Buckets
+	{
+		std::vector<uint32_t> start;
+		std::vector<uint32_t> items;
+	};
+
+	int cellX( double x ) const;
+	int cellY( double y ) const;
+	template<class BoundsFn>
+	void fill( Buckets& b, size_t count, BoundsFn&& bounds );
+	template<class DistFn>
+	int nearest( const Buckets& b, double x, double y, double maxDist, DistFn&& dist2 ) const;
+	const uint32_t* corners( uint32_t elem, int& n ) const;
+
+	double px( uint32_t v ) const { return snap_->x[v]; }
+	double py( uint32_t v ) const { return snap_->y[v]; }
+
+	std::shared_ptr<const MeshSnapshot> snap_;
+
+	double minX_ = 0, minY_ = 0, invCell_ = 1, cell_ = 1;
+	int cellsX_ = 0, cellsY_ = 0;
+	Buckets elemCells_, nodeCells_, edgeCells_;
+	double buildMs_ = 0;
+};
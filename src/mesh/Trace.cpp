@@ -0,0 +1,171 @@
+// Trace.cpp
+#include "Trace.h"
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+    struct Event
+    {
+        const char* name;
+        int64_t startNs;
+        int64_t durNs;          // < 0: instant event
+    };
+
+    // Fixed table of lazily allocated blocks, so the writer can read while the
+    // owner appends: an event is published by the release store of count
+    constexpr size_t kBlockEvents = 16384;
+    constexpr size_t kMaxBlocks = 256;       // 4M events per thread, then drop
+
+    struct ThreadBuffer
+    {
+        uint32_t tid = 0;
+        std::string name;
+        bool named = false;     // by setThreadName(), not "thread <tid>"
+        bool live = false;      // a running thread appends to it
+        std::atomic<Event*> blocks[kMaxBlocks] = {};
+        std::atomic<size_t> count{ 0 };
+        ~ThreadBuffer()
+        {
+            for ( auto& b : blocks ) delete[] b.load();
+        }
+    };
+
+    const auto gOrigin = std::chrono::steady_clock::now();
+    std::atomic<int64_t> gSessionStart{ 0 };
+
+    // Buffers outlive their threads so a trace can be written after a job
+    // ends. A thread that exits hands its buffer back, and the next thread of
+    // the same name (or the next unnamed one) appends to it: one buffer per
+    // kind of job, however many times the job runs
+    std::mutex gRegistryMutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> gRegistry;
+
+    struct ThreadSlot
+    {
+        ThreadBuffer* buffer = nullptr;
+        const char* name = nullptr;     // setThreadName(); a literal
+        ~ThreadSlot()
+        {
+            if ( !buffer ) return;
+            std::lock_guard lock( gRegistryMutex );
+            buffer->live = false;
+        }
+    };
+    thread_local ThreadSlot tSlot;
+
+    // registers on the first event, so threads that never record cost nothing
+    ThreadBuffer& threadBuffer()
+    {
+        if ( !tSlot.buffer )
+        {
+            std::lock_guard lock( gRegistryMutex );
+            const std::string name = tSlot.name ? tSlot.name : "";
+            for ( const auto& b : gRegistry )
+                if ( !b->live && b->named == bool( tSlot.name ) && (!tSlot.name || b->name == name) )
+                {
+                    tSlot.buffer = b.get();
+                    break;
+                }
+            if ( !tSlot.buffer )
+            {
+                gRegistry.push_back( std::make_unique<ThreadBuffer>() );
+                tSlot.buffer = gRegistry.back().get();
+                tSlot.buffer->tid = uint32_t( gRegistry.size() );
+                tSlot.buffer->named = tSlot.name != nullptr;
+                tSlot.buffer->name = tSlot.name ? name : "thread " + std::to_string( tSlot.buffer->tid );
+            }
+            tSlot.buffer->live = true;
+        }
+        return *tSlot.buffer;
+    }
+
+    // JSON string body; names are code literals, so only quotes and backslashes
+    std::string escaped( const char* s )
+    {
+        std::string out;
+        for ( ; *s; ++s )
+        {
+            if ( *s == '"' || *s == '\\' ) out += '\\';
+            out += *s;
+        }
+        return out;
+    }
+}
+
+std::atomic<bool> Trace::detail::on{ false };
+
+int64_t Trace::detail::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - gOrigin ).count();
+}
+
+void Trace::detail::record( const char* name, int64_t startNs, int64_t durNs )
+{
+    ThreadBuffer& b = threadBuffer();
+    const size_t i = b.count.load( std::memory_order_relaxed );   // only this thread writes it
+    const size_t block = i / kBlockEvents;
+    if ( block >= kMaxBlocks ) return;
+    Event* events = b.blocks[block].load( std::memory_order_relaxed );
+    if ( !events )
+    {
+        events = new Event[kBlockEvents];
+        b.blocks[block].store( events, std::memory_order_release );
+    }
+    events[i % kBlockEvents] = { name, startNs, durNs };
+    b.count.store( i + 1, std::memory_order_release );
+}
+
+void Trace::setEnabled( bool b )
+{
+    if ( b && !enabled() ) gSessionStart = detail::now();
+    detail::on.store( b, std::memory_order_relaxed );
+}
+
+void Trace::setThreadName( const char* name )
+{
+    // only remembered; the buffer is picked (or renamed) at the first event
+    tSlot.name = name;
+    if ( !tSlot.buffer ) return;
+    std::lock_guard lock( gRegistryMutex );
+    tSlot.buffer->name = name;
+    tSlot.buffer->named = true;
+}
+
+bool Trace::write( const std::string& path )
+{
+    FILE* f = std::fopen( path.c_str(), "w" );
+    if ( !f ) return false;
+
+    const int64_t session = gSessionStart;
+    std::lock_guard lock( gRegistryMutex );
+    std::fprintf( f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n" );
+    bool first = true;
+    auto sep = [&] { if ( !first ) std::fprintf( f, ",\n" ); first = false; };
+    for ( const auto& b : gRegistry )
+    {
+        sep();
+        std::fprintf( f, "{\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"name\":\"thread_name\",\"args\":{\"name\":\"%s\"}}",
+                      b->tid, escaped( b->name.c_str() ).c_str() );
+        const size_t n = b->count.load( std::memory_order_acquire );
+        for ( size_t i = 0; i < n; ++i )
+        {
+            const Event& e = b->blocks[i / kBlockEvents].load( std::memory_order_acquire )[i % kBlockEvents];
+            if ( e.startNs < session ) continue;
+            sep();
+            // Chrome wants microseconds
+            if ( e.durNs < 0 )
+                std::fprintf( f, "{\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":%u,\"name\":\"%s\",\"ts\":%.3f}",
+                              b->tid, escaped( e.name ).c_str(), e.startNs * 1e-3 );
+            else
+                std::fprintf( f, "{\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"name\":\"%s\",\"ts\":%.3f,\"dur\":%.3f}",
+                              b->tid, escaped( e.name ).c_str(), e.startNs * 1e-3, e.durNs * 1e-3 );
+        }
+    }
+    std::fprintf( f, "\n]}\n" );
+    return std::fclose( f ) == 0;
+}
@@ -0,0 +1,53 @@
+// Trace.h
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Scoped trace events for end-to-end latency (open, load, QMorph, upload,
+// first frame), written as Chrome Trace Event JSON for Perfetto or
+// chrome://tracing. Each thread appends to its own buffer without locks;
+// only a thread's first event takes a mutex, to register the buffer (or take
+// over the one an exited thread of the same name left behind).
+// While tracing is off, a Scope costs one relaxed load and a branch.
+//
+// Event names are not copied: pass string literals.
+namespace Trace
+{
+	namespace detail
+	{
+		extern std::atomic<bool> on;
+		int64_t now();          // ns since process start
+		void record( const char* name, int64_t startNs, int64_t durNs );
+	}
+
+	inline bool enabled() { return detail::on.load( std::memory_order_relaxed ); }
+	void setEnabled( bool b );  // enabling starts a new session
+	void setThreadName( const char* name );     // a literal; allocates nothing
+	// events of the current (or last) session; false if the file cannot be written
+	bool write( const std::string& path );
+
+	// a point in time, e.g. the click that starts a load
+	inline void instant( const char* name )
+	{
+		if ( enabled() ) detail::record( name, detail::now(), -1 );
+	}
+
+	class Scope
+	{
+	public:
+		explicit Scope( const char* name )
+		{
+			if ( enabled() ) { name_ = name; start_ = detail::now(); }
+		}
+		~Scope()
+		{
+			if ( name_ ) detail::record( name_, start_, detail::now() - start_ );
+		}
+		Scope( const Scope& ) = delete;
+		Scope& operator=( const Scope& ) = delete;
+	private:
+		const char* name_ = nullptr;
+		int64_t start_ = 0;
+	};
+}